@@ -0,0 +1,375 @@
+#!/usr/bin/env python
+#  bench.py -- A benchmark suite for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""A benchmark suite for QuineMcCluskey.simplify.
+
+The suite consists of fixed-seed random functions of 4 to 22 bits with
+different densities and don't care ratios, dense functions with many large
+merge rounds, and of families which are known to be hard for two-level
+minimisation: parity functions, multiplexers and the output bits of adders.
+Each case is run with and without use_xor, for each selected backend, in a
+fresh worker process so that the peak RSS is that of the case alone.
+
+The results are written as JSON:
+
+    {"python": ..., "platform": ..., "version": ..., "results": [
+        {"name": "random-8-0.5-0.1", "backend": "c", "use_xor": false,
+         "n_bits": 8, "n_ones": 117, "n_dc": 14, "wall_time": 0.0123,
+         "peak_rss_kb": 10240, "profile_cmp": 1530, "profile_xor": 0,
+         "profile_xnor": 0, "n_terms": 31, "status": "complete",
+         "stats": {"times": {"primes": 0.004, ...}, ...}}, ...]}
+
+The stats entry holds the per-phase times and counters of the call (see
+quine_mccluskey.stats).
+
+With --workers N, the cases of the "python" backend are also run with N
+worker processes for the merge rounds (see quine_mccluskey.parallel), and
+the speedup of the prime implicant phase and of the whole call over the
+serial run is printed for each case. The merge rounds of a case only go to
+the pool once a round has parallel.MIN_TERMS terms, so the gain shows on
+the larger cases (for example --filter dense --workers 4); it needs at least
+N idle cores.
+
+With --compare, the results are checked against an earlier JSON file: a
+case is reported as a regression if its wall time grew by more than the
+threshold factor, or if its counters or its number of terms changed.
+
+Example:
+    PYTHONPATH=. python benchmarks/bench.py --quick -o bench.json
+    PYTHONPATH=. python benchmarks/bench.py --compare bench.json
+"""
+
+from __future__ import print_function
+import argparse
+import json
+import multiprocessing
+import platform
+import random
+import sys
+import time
+try:
+    import resource
+except ImportError:
+    resource = None
+from quine_mccluskey import qm as qm_module
+from quine_mccluskey.qm import QuineMcCluskey
+
+
+
+def random_function(n_bits, density, dc_ratio, seed):
+    """A random function with a fixed seed.
+
+    Each minterm is in the ON-set with probability density; the remaining
+    minterms are don't cares with probability dc_ratio.
+    """
+    rnd = random.Random(seed)
+    ones = set()
+    dc = set()
+    for t in range(1 << n_bits):
+        r = rnd.random()
+        if r < density:
+            ones.add(t)
+        elif r < density + (1.0 - density) * dc_ratio:
+            dc.add(t)
+    return ones, dc
+
+
+
+def cube_function(n_bits, n_cubes, dc_ratio, seed):
+    """A wide function made of a few random cubes.
+
+    Each cube has about n_bits / 4 free bits; the don't cares are drawn from
+    the cubes of a second, smaller set.
+    """
+    rnd = random.Random(seed)
+
+    def cubes(n):
+        res = set()
+        for i in range(n):
+            mask = rnd.getrandbits(n_bits) & rnd.getrandbits(n_bits)
+            value = rnd.getrandbits(n_bits) & ~mask
+            sub = 0
+            while True:
+                res.add(value | sub)
+                sub = (sub - mask) & mask
+                if sub == 0:
+                    break
+        return res
+
+    ones = cubes(n_cubes)
+    dc = cubes(int(n_cubes * dc_ratio + 0.5)) - ones
+    return ones, dc
+
+
+
+def parity_function(n_bits):
+    """The odd parity of n_bits inputs: 2**(n_bits - 1) prime implicants."""
+    return set(t for t in range(1 << n_bits) if bin(t).count('1') % 2), set()
+
+
+
+def mux_function(n_select):
+    """A multiplexer with n_select select inputs and 2**n_select data inputs.
+
+    The select inputs are the most significant bits.
+    """
+    n_data = 1 << n_select
+    ones = set()
+    for t in range(1 << (n_select + n_data)):
+        if t >> (t >> n_data) & 1:
+            ones.add(t)
+    return ones, set()
+
+
+
+def adder_function(n, bit):
+    """Output bit 'bit' of the sum of two n bit numbers.
+
+    The inputs are the two operands, the first one in the most significant
+    bits. Bit n is the carry out.
+    """
+    ones = set()
+    for t in range(1 << (2 * n)):
+        a = t >> n
+        b = t & ((1 << n) - 1)
+        if (a + b) >> bit & 1:
+            ones.add(t)
+    return ones, set()
+
+
+
+def get_cases(quick = False):
+    """Return the list of the benchmark cases.
+
+    Each case is a tuple (name, n_bits, (generator, args)); the generator
+    is called with args in the worker process and returns (ones, dc).
+    """
+    cases = []
+    sizes = (4, 8) if quick else (4, 6, 8, 10, 12)
+    for n_bits in sizes:
+        for density in (0.2, 0.5):
+            for dc_ratio in (0.0, 0.1):
+                name = "random-%d-%g-%g" % (n_bits, density, dc_ratio)
+                cases.append((name, n_bits, (random_function, (n_bits, density, dc_ratio, n_bits))))
+    # Dense functions with many large merge rounds, for --workers.
+    for n_bits in (() if quick else (13, 14)):
+        name = "dense-%d-0.7-0.1" % n_bits
+        cases.append((name, n_bits, (random_function, (n_bits, 0.7, 0.1, n_bits))))
+    for n_bits in ((16,) if quick else (16, 20, 22)):
+        for dc_ratio in (0.0, 0.5):
+            name = "cubes-%d-%g" % (n_bits, dc_ratio)
+            cases.append((name, n_bits, (cube_function, (n_bits, 8, dc_ratio, n_bits))))
+    for n_bits in ((4, 6) if quick else (4, 6, 8, 10)):
+        cases.append(("parity-%d" % n_bits, n_bits, (parity_function, (n_bits,))))
+    for n_select in ((2,) if quick else (2, 3)):
+        cases.append(("mux-%d" % n_select, n_select + (1 << n_select), (mux_function, (n_select,))))
+    for n in ((2,) if quick else (2, 3, 4)):
+        for bit in (n - 1, n):
+            cases.append(("adder-%d-s%d" % (n, bit), 2 * n, (adder_function, (n, bit))))
+    return cases
+
+
+
+def _peak_rss_kb():
+    """The peak resident set size of this process in KiB, or None."""
+    if resource is None:
+        return None
+    rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # macOS reports bytes, other systems KiB.
+    return rss // 1024 if sys.platform == 'darwin' else rss
+
+
+
+def run_case(task):
+    """Run one case in a worker process.
+
+    Args:
+        task (tuple): (case, backend, use_xor, cover_budget, deadline, prune_dc,
+        workers).
+
+    Returns:
+        A dict with the results of the case.
+    """
+    (name, n_bits, (generator, args)), backend, use_xor, cover_budget, deadline, prune_dc, workers = task
+    ones, dc = generator(*args)
+    qm = QuineMcCluskey(use_xor = use_xor, backend = backend, cover_budget = cover_budget,
+                        prune_dc = prune_dc, workers = workers)
+    t1 = time.time()
+    res = qm.simplify(ones, dc, num_bits = n_bits, deadline = deadline)
+    t2 = time.time()
+    return dict(name = name, backend = backend, use_xor = use_xor, workers = workers, n_bits = n_bits,
+                n_ones = len(ones), n_dc = len(dc), wall_time = round(t2 - t1, 6),
+                peak_rss_kb = _peak_rss_kb(), profile_cmp = qm.profile_cmp,
+                profile_xor = qm.profile_xor, profile_xnor = qm.profile_xnor,
+                n_terms = len(res), status = qm.status, stats = qm.stats.as_dict())
+
+
+
+def _run_child(conn, task):
+    """The body of the process of run_isolated."""
+    conn.send(run_case(task))
+    conn.close()
+
+
+
+def run_isolated(task):
+    """Run one case in a fresh process.
+
+    The process is not a daemon, so that a case with workers > 1 can start
+    its own pool. The peak RSS is that of the process of the case, without
+    its worker processes.
+
+    Returns:
+        see: run_case.
+    """
+    parent, child = multiprocessing.Pipe(False)
+    proc = multiprocessing.Process(target = _run_child, args = (child, task))
+    proc.start()
+    child.close()
+    try:
+        return parent.recv()
+    finally:
+        proc.join()
+
+
+
+def available_backends():
+    """The backends which can be used in this installation."""
+    res = ["python", "zdd"]
+    if qm_module.numpy_backend is not None:
+        res.append("numpy")
+    if qm_module._qm is not None:
+        res.append("c")
+    return res
+
+
+
+def compare(results, baseline, threshold):
+    """Compare results with the results of an earlier run.
+
+    Returns:
+        A list of strings, one for each regression.
+    """
+    key = lambda r: (r['name'], r['backend'], r['use_xor'], r.get('workers', 1))
+    old = dict((key(r), r) for r in baseline['results'])
+    res = []
+    for r in results:
+        o = old.get(key(r))
+        if o is None:
+            continue
+        label = "%s (%s%s%s)" % (r['name'], r['backend'], ", xor" if r['use_xor'] else "",
+                                 ", %d workers" % r['workers'] if r['workers'] > 1 else "")
+        # Very short runs are dominated by noise.
+        if r['wall_time'] > threshold * o['wall_time'] and r['wall_time'] - o['wall_time'] > 0.01:
+            res.append("%s: %.4f s, was %.4f s" % (label, r['wall_time'], o['wall_time']))
+        for field in ('profile_cmp', 'profile_xor', 'profile_xnor', 'n_terms'):
+            if r['status'] == o['status'] == 'complete' and r[field] != o[field]:
+                res.append("%s: %s %d, was %d" % (label, field, r[field], o[field]))
+    return res
+
+
+
+def speedups(results):
+    """Compare the runs with worker processes with the serial runs.
+
+    Returns:
+        A list of strings, one for each case run with workers > 1.
+    """
+    key = lambda r: (r['name'], r['backend'], r['use_xor'])
+    serial = dict((key(r), r) for r in results if r['workers'] == 1)
+    res = []
+    for r in results:
+        s = serial.get(key(r))
+        if r['workers'] == 1 or s is None:
+            continue
+        t1 = s['stats']['times'].get('primes', 0.0)
+        t2 = r['stats']['times'].get('primes', 0.0)
+        res.append("%-20s %-5s %d workers: primes %.4f s -> %.4f s (x%.2f), total %.4f s -> %.4f s (x%.2f)" % (
+            r['name'], "xor" if r['use_xor'] else "", r['workers'], t1, t2, t1 / max(t2, 1e-9),
+            s['wall_time'], r['wall_time'], s['wall_time'] / max(r['wall_time'], 1e-9)))
+    return res
+
+
+
+def main():
+    parser = argparse.ArgumentParser(description = "Run the qm.py benchmark suite.")
+    parser.add_argument("-o", "--output", help = "write the JSON results to this file")
+    parser.add_argument("--quick", action = "store_true", help = "run a small subset of the cases")
+    parser.add_argument("--backend", action = "append", choices = QuineMcCluskey.backends,
+                        help = "benchmark this backend (repeatable; default: all available)")
+    parser.add_argument("--filter", default = "", help = "run only the cases whose name contains this string")
+    parser.add_argument("--cover-budget", type = float, default = 1.0, help = "the cover_budget of each case")
+    parser.add_argument("--deadline", type = float, default = 60.0, help = "the deadline of each case in seconds")
+    parser.add_argument("--prune-dc", action = "store_true", help = "skip the DC-only implicants (python backend)")
+    parser.add_argument("--workers", type = int, default = 1,
+                        help = "also run the python backend with this number of worker processes")
+    parser.add_argument("--compare", help = "compare with the JSON results of an earlier run")
+    parser.add_argument("--threshold", type = float, default = 1.25,
+                        help = "the factor of wall time growth reported as regression")
+    args = parser.parse_args()
+
+    baseline = None
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+
+    backends = args.backend or available_backends()
+    tasks = [(case, backend, use_xor, args.cover_budget, args.deadline, args.prune_dc, workers)
+             for case in get_cases(args.quick) if args.filter in case[0]
+             for use_xor in (False, True)
+             for backend in backends
+             for workers in sorted(set([1, args.workers if backend == "python" else 1]))]
+
+    # One process per case, so that the peak RSS is not inherited from the
+    # previous cases.
+    results = []
+    for task in tasks:
+        r = run_isolated(task)
+        print("%-20s %-6s %-5s %2d %10.4f s %8s KiB %6d terms  %s" % (
+            r['name'], r['backend'], "xor" if r['use_xor'] else "", r['workers'], r['wall_time'],
+            r['peak_rss_kb'], r['n_terms'], r['status']), file = sys.stderr)
+        results.append(r)
+
+    report = dict(version = QuineMcCluskey.__version__, python = platform.python_version(),
+                  platform = platform.platform(), results = results)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent = 1, sort_keys = True)
+    else:
+        json.dump(report, sys.stdout, indent = 1, sort_keys = True)
+        print()
+
+    for line in speedups(results):
+        print("speedup: %s" % line, file = sys.stderr)
+
+    if baseline is not None:
+        regressions = compare(results, baseline, args.threshold)
+        for line in regressions:
+            print("regression: %s" % line, file = sys.stderr)
+        if regressions:
+            return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
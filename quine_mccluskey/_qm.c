@@ -0,0 +1,880 @@
+/*
+ *  _qm.c -- Compiled core of the Quine McCluskey Python implementation
+ *
+ *  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+/*
+ * This module implements the prime implicant generation of qm.py in C. It
+ * is used automatically by the QuineMcCluskey class when it is available;
+ * qm.py remains the reference implementation and is used as fallback.
+ *
+ * Terms are packed in the same way as in qm.py: (value, mask, xor_mask,
+ * xnor_mask), limited to 64 bits. The computation runs without holding the
+ * GIL; it takes the GIL only to call the optional stop callable, before each
+ * merge round and every QM_STOP_TERMS terms within a round.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QM_MAX_BITS 64
+#define QM_STOP_TERMS 65536
+
+
+typedef struct {
+    uint64_t value;
+    uint64_t mask;
+    uint64_t xor_mask;
+    uint64_t xnor_mask;
+} qm_term;
+
+/* A growable array of terms. */
+typedef struct {
+    qm_term *terms;
+    size_t len;
+    size_t cap;
+} qm_vec;
+
+/* An open-addressing hash set over the terms of a qm_vec. */
+typedef struct {
+    size_t *slots;      /* index + 1 into the vector, 0 marks an empty slot */
+    size_t n_slots;     /* a power of two */
+    size_t len;
+} qm_index;
+
+typedef struct {
+    unsigned long long n_cmp;
+    unsigned long long n_xor;
+    unsigned long long n_xnor;
+} qm_profile;
+
+/* The stop callable of a call and its outcome. */
+typedef struct {
+    PyObject *fn;       /* called with the progress of the rounds, or NULL */
+    int stopped;        /* fn returned a true value */
+    int error;          /* fn raised an exception, which is still set */
+} qm_stop;
+
+
+
+static int popcount64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+
+static size_t term_hash(const qm_term *t)
+{
+    uint64_t h = t->value * 0x9e3779b97f4a7c15ULL;
+    h ^= (t->mask + 0x632be59bd9b4e019ULL) * 0xc2b2ae3d27d4eb4fULL;
+    h ^= (t->xor_mask + 0x27d4eb2f165667c5ULL) * 0x165667b19e3779f9ULL;
+    h ^= (t->xnor_mask + 0x85ebca77c2b2ae63ULL) * 0xd6e8feb86659fd93ULL;
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return (size_t)h;
+}
+
+
+
+static int term_eq(const qm_term *a, const qm_term *b)
+{
+    return a->value == b->value && a->mask == b->mask &&
+        a->xor_mask == b->xor_mask && a->xnor_mask == b->xnor_mask;
+}
+
+
+
+static int vec_push(qm_vec *v, const qm_term *t)
+{
+    if (v->len == v->cap) {
+        size_t cap = v->cap ? 2 * v->cap : 64;
+        qm_term *terms = (qm_term *)realloc(v->terms, cap * sizeof(qm_term));
+        if (terms == NULL) {
+            return -1;
+        }
+        v->terms = terms;
+        v->cap = cap;
+    }
+    v->terms[v->len++] = *t;
+    return 0;
+}
+
+
+
+static int index_init(qm_index *ix, size_t n)
+{
+    size_t n_slots = 16;
+    while (n_slots < 2 * n) {
+        n_slots *= 2;
+    }
+    ix->slots = (size_t *)calloc(n_slots, sizeof(size_t));
+    if (ix->slots == NULL) {
+        return -1;
+    }
+    ix->n_slots = n_slots;
+    ix->len = 0;
+    return 0;
+}
+
+
+
+static void index_free(qm_index *ix)
+{
+    free(ix->slots);
+    ix->slots = NULL;
+    ix->n_slots = 0;
+    ix->len = 0;
+}
+
+
+
+/* Return the index of t in terms or -1 if t is not contained in the index. */
+static Py_ssize_t index_find(const qm_index *ix, const qm_term *terms, const qm_term *t)
+{
+    size_t i = term_hash(t) & (ix->n_slots - 1);
+    while (ix->slots[i] != 0) {
+        size_t k = ix->slots[i] - 1;
+        if (term_eq(&terms[k], t)) {
+            return (Py_ssize_t)k;
+        }
+        i = (i + 1) & (ix->n_slots - 1);
+    }
+    return -1;
+}
+
+
+
+static int index_grow(qm_index *ix, const qm_term *terms)
+{
+    size_t *old = ix->slots;
+    size_t old_n = ix->n_slots;
+    size_t n_slots = 2 * old_n;
+    size_t i;
+
+    ix->slots = (size_t *)calloc(n_slots, sizeof(size_t));
+    if (ix->slots == NULL) {
+        ix->slots = old;
+        return -1;
+    }
+    ix->n_slots = n_slots;
+    for (i = 0; i < old_n; i++) {
+        if (old[i] != 0) {
+            size_t j = term_hash(&terms[old[i] - 1]) & (n_slots - 1);
+            while (ix->slots[j] != 0) {
+                j = (j + 1) & (n_slots - 1);
+            }
+            ix->slots[j] = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+
+
+/* Append t to v unless it is already contained. Returns -1 on error. */
+static int vec_add_unique(qm_vec *v, qm_index *ix, const qm_term *t)
+{
+    size_t i;
+
+    if (2 * (ix->len + 1) > ix->n_slots && index_grow(ix, v->terms) < 0) {
+        return -1;
+    }
+    i = term_hash(t) & (ix->n_slots - 1);
+    while (ix->slots[i] != 0) {
+        if (term_eq(&v->terms[ix->slots[i] - 1], t)) {
+            return 0;
+        }
+        i = (i + 1) & (ix->n_slots - 1);
+    }
+    if (vec_push(v, t) < 0) {
+        return -1;
+    }
+    ix->slots[i] = v->len;
+    ix->len++;
+    return 0;
+}
+
+
+
+/*
+ * Add the 'simple' XOR and XNOR terms, i.e. the terms obtained by combining
+ * just two bits of two input terms, to v. The partners of a term differ in
+ * exactly two bits, so they are looked up in the index by flipping a '1' and
+ * a higher '0' (XOR) or two '0's (XNOR) of the term.
+ */
+static int add_simple_xor_terms(qm_vec *v, qm_index *ix, int n_bits)
+{
+    uint64_t all_bits = n_bits >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << n_bits) - 1);
+    size_t n = v->len;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        qm_term t1 = v->terms[i];
+        uint64_t zeros, ones, rest;
+
+        if (t1.xor_mask || t1.xnor_mask) {
+            continue;
+        }
+        zeros = all_bits & ~(t1.value | t1.mask);
+        for (ones = t1.value; ones; ones &= ones - 1) {
+            uint64_t b1 = ones & (~ones + 1);
+            uint64_t higher = zeros & ~(2 * b1 - 1);
+            for (; higher; higher &= higher - 1) {
+                uint64_t b2 = higher & (~higher + 1);
+                qm_term t2 = { t1.value ^ b1 ^ b2, t1.mask, 0, 0 };
+                if (index_find(ix, v->terms, &t2) >= 0) {
+                    qm_term t12 = { t1.value & ~b1, t1.mask, b1 | b2, 0 };
+                    if (vec_add_unique(v, ix, &t12) < 0) {
+                        return -1;
+                    }
+                }
+            }
+        }
+        for (rest = zeros; rest; ) {
+            uint64_t b1 = rest & (~rest + 1);
+            uint64_t higher;
+            rest ^= b1;
+            for (higher = rest; higher; higher &= higher - 1) {
+                uint64_t b2 = higher & (~higher + 1);
+                qm_term t2 = { t1.value | b1 | b2, t1.mask, 0, 0 };
+                if (index_find(ix, v->terms, &t2) >= 0) {
+                    qm_term t12 = { t1.value, t1.mask, 0, b1 | b2 };
+                    if (vec_add_unique(v, ix, &t12) < 0) {
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+
+
+/*
+ * Empty ix and size it for about n terms. The slot array is kept unless it
+ * is too small or more than four times too large.
+ */
+static int index_reset(qm_index *ix, size_t n)
+{
+    size_t n_slots = 16;
+    while (n_slots < 2 * n) {
+        n_slots *= 2;
+    }
+    if (ix->slots == NULL || n_slots > ix->n_slots || 4 * n_slots < ix->n_slots) {
+        index_free(ix);
+        return index_init(ix, n);
+    }
+    memset(ix->slots, 0, ix->n_slots * sizeof(size_t));
+    ix->len = 0;
+    return 0;
+}
+
+
+
+/*
+ * Call the stop callable with the number of rounds done, of primes and of
+ * all implicants so far, taking the GIL for the call. Returns non-zero if
+ * the merge rounds have to stop.
+ */
+static int check_stop(qm_stop *stop, size_t n_round, size_t n_primes, size_t n_terms)
+{
+    PyGILState_STATE gil;
+    PyObject *res;
+
+    if (stop->fn == NULL) {
+        return 0;
+    }
+    gil = PyGILState_Ensure();
+    res = PyObject_CallFunction(stop->fn, "nnn", (Py_ssize_t)n_round, (Py_ssize_t)n_primes,
+            (Py_ssize_t)n_terms);
+    if (res == NULL) {
+        stop->error = 1;
+    } else {
+        int truth = PyObject_IsTrue(res);
+        Py_DECREF(res);
+        if (truth < 0) {
+            stop->error = 1;
+        } else if (truth) {
+            stop->stopped = 1;
+        }
+    }
+    PyGILState_Release(gil);
+    return stop->stopped || stop->error;
+}
+
+
+
+/*
+ * The merge rounds of the Quine McCluskey method. cur holds the unique
+ * input terms on entry and ix indexes them; both are freed on exit. The
+ * prime implicants are appended to pi.
+ *
+ * If stop says so before a round or within one, the round is abandoned and
+ * its input terms are appended to pi: they cover all terms, like the
+ * implicants of an interrupted round of qm.py.
+ *
+ * The terms of a round and of the next round live in two arenas which are
+ * swapped after each round, together with their hash sets: the set built
+ * while adding the new terms indexes the input of the next round. The set
+ * of the new terms starts at the size of the previous round and grows by
+ * doubling, so the buffers settle at the size of the largest rounds instead
+ * of being allocated and freed in every round.
+ */
+static int merge_rounds(qm_vec *cur, qm_index *ix, int n_bits, qm_vec *pi, qm_profile *prof,
+                        qm_stop *stop)
+{
+    uint64_t all_bits = n_bits >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << n_bits) - 1);
+    size_t dim = (size_t)n_bits + 2;
+    unsigned char *keys = (unsigned char *)malloc(dim * dim * dim);
+    qm_vec next = { NULL, 0, 0 };
+    qm_index next_ix = { NULL, 0, 0 };
+    unsigned char *used = NULL;
+    size_t used_cap = 0;
+    size_t n_round = 0;
+    size_t j;
+    int ret = -1;
+
+    if (keys == NULL) {
+        goto out;
+    }
+
+    for (;;) {
+        size_t n_used = 0;
+        size_t i;
+
+        if (check_stop(stop, n_round, pi->len, pi->len + cur->len)) {
+            goto stopped;
+        }
+
+        /* Record which (n_ones, n_xor, n_xnor) groups are populated. */
+        memset(keys, 0, dim * dim * dim);
+        for (i = 0; i < cur->len; i++) {
+            const qm_term *t = &cur->terms[i];
+            keys[((size_t)popcount64(t->value) * dim + popcount64(t->xor_mask)) * dim + popcount64(t->xnor_mask)] = 1;
+        }
+
+        if (cur->len > used_cap) {
+            unsigned char *u = (unsigned char *)realloc(used, cur->len);
+            if (u == NULL) {
+                goto out;
+            }
+            used = u;
+            used_cap = cur->len;
+        }
+        if (cur->len) {
+            memset(used, 0, cur->len);
+        }
+
+        /* Size the set of the new terms for as many as the last round made. */
+        next.len = 0;
+        if (index_reset(&next_ix, cur->len) < 0) {
+            goto out;
+        }
+
+        for (i = 0; i < cur->len; i++) {
+            qm_term t1 = cur->terms[i];
+            size_t n_ones = (size_t)popcount64(t1.value);
+            size_t n_xor = (size_t)popcount64(t1.xor_mask);
+            size_t n_xnor = (size_t)popcount64(t1.xnor_mask);
+            uint64_t zeros = all_bits & ~(t1.value | t1.mask | t1.xor_mask | t1.xnor_mask);
+            uint64_t z;
+            int has_complement = keys[((n_ones + 1) * dim + n_xnor) * dim + n_xor];
+
+            if (i % QM_STOP_TERMS == QM_STOP_TERMS - 1 &&
+                    check_stop(stop, n_round, pi->len, pi->len + cur->len + next.len)) {
+                goto stopped;
+            }
+            /* Find prime implicants */
+            if (keys[((n_ones + 1) * dim + n_xor) * dim + n_xnor]) {
+                for (z = zeros; z; z &= z - 1) {
+                    uint64_t bit = z & (~z + 1);
+                    qm_term t2 = { t1.value | bit, t1.mask, t1.xor_mask, t1.xnor_mask };
+                    Py_ssize_t k;
+                    prof->n_cmp++;
+                    k = index_find(ix, cur->terms, &t2);
+                    if (k >= 0) {
+                        qm_term t12 = { t1.value, t1.mask | bit, t1.xor_mask, t1.xnor_mask };
+                        used[i] = 1;
+                        used[k] = 1;
+                        if (vec_add_unique(&next, &next_ix, &t12) < 0) {
+                            goto out;
+                        }
+                    }
+                }
+            }
+            /* Find XOR combinations */
+            if (n_xor > 0 && has_complement) {
+                for (z = zeros; z; z &= z - 1) {
+                    uint64_t bit = z & (~z + 1);
+                    qm_term t2 = { t1.value | bit, t1.mask, 0, t1.xor_mask };
+                    prof->n_xor++;
+                    if (index_find(ix, cur->terms, &t2) >= 0) {
+                        qm_term t12 = { t1.value, t1.mask, t1.xor_mask | bit, 0 };
+                        used[i] = 1;
+                        if (vec_add_unique(&next, &next_ix, &t12) < 0) {
+                            goto out;
+                        }
+                    }
+                }
+            }
+            /* Find XNOR combinations */
+            if (n_xnor > 0 && has_complement) {
+                for (z = zeros; z; z &= z - 1) {
+                    uint64_t bit = z & (~z + 1);
+                    qm_term t2 = { t1.value | bit, t1.mask, t1.xnor_mask, 0 };
+                    prof->n_xnor++;
+                    if (index_find(ix, cur->terms, &t2) >= 0) {
+                        qm_term t12 = { t1.value, t1.mask, 0, t1.xnor_mask | bit };
+                        used[i] = 1;
+                        if (vec_add_unique(&next, &next_ix, &t12) < 0) {
+                            goto out;
+                        }
+                    }
+                }
+            }
+        }
+
+        /* Add the unused terms to the list of prime implicants */
+        for (i = 0; i < cur->len; i++) {
+            if (used[i]) {
+                n_used++;
+            } else if (vec_push(pi, &cur->terms[i]) < 0) {
+                goto out;
+            }
+        }
+        if (n_used == 0) {
+            break;
+        }
+
+        /* The new terms and their hash set are the input of the next round. */
+        {
+            qm_vec tv = *cur;
+            qm_index ti = *ix;
+            *cur = next;
+            *ix = next_ix;
+            next = tv;
+            next_ix = ti;
+        }
+        n_round++;
+    }
+    ret = 0;
+    goto out;
+
+stopped:
+    for (j = 0; j < cur->len; j++) {
+        if (vec_push(pi, &cur->terms[j]) < 0) {
+            goto out;
+        }
+    }
+    ret = 0;
+
+out:
+    free(keys);
+    free(used);
+    free(next.terms);
+    index_free(&next_ix);
+    index_free(ix);
+    free(cur->terms);
+    cur->terms = NULL;
+    cur->len = cur->cap = 0;
+    return ret;
+}
+
+
+
+static int parse_term(PyObject *item, qm_term *t)
+{
+    unsigned long long f[4];
+    int i;
+
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 4) {
+        PyErr_SetString(PyExc_TypeError, "terms must be tuples of four integers");
+        return -1;
+    }
+    for (i = 0; i < 4; i++) {
+        f[i] = PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(item, i));
+        if (f[i] == (unsigned long long)-1 && PyErr_Occurred()) {
+            return -1;
+        }
+    }
+    t->value = f[0];
+    t->mask = f[1];
+    t->xor_mask = f[2];
+    t->xnor_mask = f[3];
+    return 0;
+}
+
+
+
+static PyObject *build_term(const qm_term *t)
+{
+    return Py_BuildValue("(KKKK)",
+            (unsigned long long)t->value, (unsigned long long)t->mask,
+            (unsigned long long)t->xor_mask, (unsigned long long)t->xnor_mask);
+}
+
+
+
+PyDoc_STRVAR(get_prime_implicants_doc,
+"get_prime_implicants(terms, n_bits, use_xor, stop=None)\n"
+"\n"
+"Generate all prime implicants of the packed terms. terms is an iterable of\n"
+"(value, mask, xor_mask, xnor_mask) tuples of at most 64 bits. If use_xor is\n"
+"true the simple XOR and XNOR terms are added first.\n"
+"\n"
+"stop is called as stop(n_round, n_primes, n_terms) with the number of merge\n"
+"rounds done, of the primes and of all implicants so far, before each round\n"
+"and every 65536 terms of a round. If it returns true, the round is abandoned\n"
+"and its input terms are returned together with the primes found so far.\n"
+"\n"
+"Returns a tuple (pi, n_cmp, n_xor, n_xnor) of the set of packed prime\n"
+"implicants and the number of AND, XOR and XNOR comparisons.");
+
+/*
+ * Run the XOR pass and the merge rounds on the unique terms of cur, indexed
+ * by ix, and build the result tuple of get_prime_implicants. cur and ix are
+ * consumed. stop_fn is the stop callable, or None.
+ */
+static PyObject *run_prime_implicants(qm_vec *cur, qm_index *ix, int n_bits, int use_xor,
+                                      PyObject *stop_fn)
+{
+    qm_vec pi = { NULL, 0, 0 };
+    qm_profile prof = { 0, 0, 0 };
+    qm_stop stop = { stop_fn == Py_None ? NULL : stop_fn, 0, 0 };
+    PyObject *result = NULL, *pi_set = NULL;
+    int status = 0;
+    size_t i;
+
+    Py_BEGIN_ALLOW_THREADS
+    if (use_xor) {
+        status = add_simple_xor_terms(cur, ix, n_bits);
+    }
+    if (status == 0) {
+        /* The index of the input terms is reused by the first round. */
+        status = merge_rounds(cur, ix, n_bits, &pi, &prof, &stop);
+    }
+    index_free(ix);
+    Py_END_ALLOW_THREADS
+    if (stop.error) {
+        goto error;
+    }
+    if (status < 0) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    pi_set = PySet_New(NULL);
+    if (pi_set == NULL) {
+        goto error;
+    }
+    for (i = 0; i < pi.len; i++) {
+        PyObject *t = build_term(&pi.terms[i]);
+        if (t == NULL || PySet_Add(pi_set, t) < 0) {
+            Py_XDECREF(t);
+            goto error;
+        }
+        Py_DECREF(t);
+    }
+    result = Py_BuildValue("(OKKK)", pi_set, prof.n_cmp, prof.n_xor, prof.n_xnor);
+
+error:
+    Py_XDECREF(pi_set);
+    free(pi.terms);
+    return result;
+}
+
+
+
+static PyObject *get_prime_implicants(PyObject *self, PyObject *args)
+{
+    PyObject *terms_obj, *iter, *item, *stop = Py_None;
+    int n_bits, use_xor;
+    qm_vec cur = { NULL, 0, 0 };
+    qm_index ix;
+    PyObject *result = NULL;
+
+    (void)self;
+    if (!PyArg_ParseTuple(args, "Oip|O:get_prime_implicants", &terms_obj, &n_bits, &use_xor, &stop)) {
+        return NULL;
+    }
+    if (n_bits < 0 || n_bits > QM_MAX_BITS) {
+        PyErr_SetString(PyExc_ValueError, "n_bits must be between 0 and 64");
+        return NULL;
+    }
+    iter = PyObject_GetIter(terms_obj);
+    if (iter == NULL) {
+        return NULL;
+    }
+    if (index_init(&ix, 64) < 0) {
+        Py_DECREF(iter);
+        return PyErr_NoMemory();
+    }
+    while ((item = PyIter_Next(iter)) != NULL) {
+        qm_term t;
+        int rc = parse_term(item, &t);
+        Py_DECREF(item);
+        if (rc < 0) {
+            goto error;
+        }
+        if (vec_add_unique(&cur, &ix, &t) < 0) {
+            PyErr_NoMemory();
+            goto error;
+        }
+    }
+    if (PyErr_Occurred()) {
+        goto error;
+    }
+    result = run_prime_implicants(&cur, &ix, n_bits, use_xor, stop);
+
+error:
+    Py_DECREF(iter);
+    index_free(&ix);
+    free(cur.terms);
+    return result;
+}
+
+
+
+/*
+ * Add the ON (code 1) and DC (code 2) minterms below 2**n_bits of a 2 bit
+ * truth table to v. Returns -1 if out of memory, or -2 with *bad set to the
+ * offset of the byte if the table contains the invalid code 3.
+ */
+static int table_terms(const unsigned char *table, int n_bits, qm_vec *v, qm_index *ix, size_t *bad)
+{
+    uint64_t n_terms = (uint64_t)1 << n_bits;
+    size_t size = (size_t)((n_terms + 3) / 4);
+    size_t i = 0;
+
+    while (i < size) {
+        unsigned char b;
+        int k;
+
+        /* Skip all-OFF stretches a word at a time. */
+        if ((i & 7) == 0 && i + 8 <= size) {
+            uint64_t w;
+            memcpy(&w, table + i, 8);
+            if (w == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        b = table[i];
+        for (k = 0; k < 4 && b; k++, b >>= 2) {
+            if ((b & 3) == 3) {
+                *bad = i;
+                return -2;
+            }
+            if ((b & 3) && 4 * (uint64_t)i + (uint64_t)k < n_terms) {
+                qm_term t = { 4 * (uint64_t)i + (uint64_t)k, 0, 0, 0 };
+                if (vec_add_unique(v, ix, &t) < 0) {
+                    return -1;
+                }
+            }
+        }
+        i++;
+    }
+    return 0;
+}
+
+
+
+/* Check the size of a truth table buffer. */
+static int check_table(const Py_buffer *view, int n_bits)
+{
+    if (n_bits < 0 || n_bits > 40) {
+        PyErr_SetString(PyExc_ValueError, "n_bits must be between 0 and 40");
+        return -1;
+    }
+    if ((uint64_t)view->len < (((uint64_t)1 << n_bits) + 3) / 4) {
+        PyErr_SetString(PyExc_ValueError, "the truth table is too short");
+        return -1;
+    }
+    return 0;
+}
+
+
+
+PyDoc_STRVAR(table_prime_implicants_doc,
+"table_prime_implicants(table, n_bits, use_xor, stop=None)\n"
+"\n"
+"Generate all prime implicants of the ON and DC minterms of a truth table.\n"
+"table is a bytes-like object, e.g. a memoryview of a memory-mapped file, in\n"
+"the 2 bit encoding of quine_mccluskey.truthtable; it is read in place,\n"
+"without building Python objects for the minterms. Only the first\n"
+"2**n_bits entries are read.\n"
+"\n"
+"stop and the result are those of get_prime_implicants.");
+
+static PyObject *table_prime_implicants(PyObject *self, PyObject *args)
+{
+    Py_buffer view;
+    PyObject *stop = Py_None;
+    int n_bits, use_xor;
+    qm_vec cur = { NULL, 0, 0 };
+    qm_index ix;
+    PyObject *result = NULL;
+    size_t bad = 0;
+    int status;
+
+    (void)self;
+    if (!PyArg_ParseTuple(args, "y*ip|O:table_prime_implicants", &view, &n_bits, &use_xor, &stop)) {
+        return NULL;
+    }
+    if (check_table(&view, n_bits) < 0) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    if (index_init(&ix, 64) < 0) {
+        PyBuffer_Release(&view);
+        return PyErr_NoMemory();
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = table_terms((const unsigned char *)view.buf, n_bits, &cur, &ix, &bad);
+    Py_END_ALLOW_THREADS
+    if (status == -1) {
+        PyErr_NoMemory();
+    } else if (status == -2) {
+        PyErr_Format(PyExc_ValueError, "invalid code at byte %zu", bad);
+    } else {
+        result = run_prime_implicants(&cur, &ix, n_bits, use_xor, stop);
+    }
+    PyBuffer_Release(&view);
+    index_free(&ix);
+    free(cur.terms);
+    return result;
+}
+
+
+
+PyDoc_STRVAR(decode_table_doc,
+"decode_table(table)\n"
+"\n"
+"Decode all entries of a truth table (see table_prime_implicants),\n"
+"including the padding.\n"
+"\n"
+"Returns a tuple (ones, dc) of the sets of the ON and DC minterms.");
+
+static PyObject *decode_table(PyObject *self, PyObject *args)
+{
+    Py_buffer view;
+    PyObject *sets[3] = { NULL, NULL, NULL };
+    PyObject *result = NULL;
+    const unsigned char *table;
+    size_t size, i;
+
+    (void)self;
+    if (!PyArg_ParseTuple(args, "y*:decode_table", &view)) {
+        return NULL;
+    }
+    sets[1] = PySet_New(NULL);
+    sets[2] = PySet_New(NULL);
+    if (sets[1] == NULL || sets[2] == NULL) {
+        goto out;
+    }
+    table = (const unsigned char *)view.buf;
+    size = (size_t)view.len;
+    for (i = 0; i < size; i++) {
+        unsigned char b = table[i];
+        int k;
+        if ((i & 7) == 0 && i + 8 <= size) {
+            uint64_t w;
+            memcpy(&w, table + i, 8);
+            if (w == 0) {
+                i += 7;
+                continue;
+            }
+        }
+        for (k = 0; k < 4 && b; k++, b >>= 2) {
+            PyObject *m;
+            int rc;
+            if ((b & 3) == 0) {
+                continue;
+            }
+            if ((b & 3) == 3) {
+                PyErr_Format(PyExc_ValueError, "invalid code at byte %zu", i);
+                goto out;
+            }
+            m = PyLong_FromUnsignedLongLong(4 * (unsigned long long)i + (unsigned long long)k);
+            if (m == NULL) {
+                goto out;
+            }
+            rc = PySet_Add(sets[b & 3], m);
+            Py_DECREF(m);
+            if (rc < 0) {
+                goto out;
+            }
+        }
+    }
+    result = PyTuple_Pack(2, sets[1], sets[2]);
+
+out:
+    Py_XDECREF(sets[1]);
+    Py_XDECREF(sets[2]);
+    PyBuffer_Release(&view);
+    return result;
+}
+
+
+
+static PyMethodDef qm_methods[] = {
+    { "get_prime_implicants", get_prime_implicants, METH_VARARGS, get_prime_implicants_doc },
+    { "table_prime_implicants", table_prime_implicants, METH_VARARGS, table_prime_implicants_doc },
+    { "decode_table", decode_table, METH_VARARGS, decode_table_doc },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef qm_module = {
+    PyModuleDef_HEAD_INIT,
+    "_qm",
+    "Compiled core of the Quine McCluskey algorithm.",
+    -1,
+    qm_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit__qm(void)
+{
+    PyObject *m = PyModule_Create(&qm_module);
+    if (m == NULL) {
+        return NULL;
+    }
+    if (PyModule_AddIntConstant(m, "MAX_BITS", QM_MAX_BITS) < 0) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,147 @@
+#  aio.py -- asyncio support for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+
+"""Calls of QuineMcCluskey.simplify from asyncio code.
+
+A SimplifyTask runs simplify in an executor, so that the event loop keeps
+running while the function is minimised; the merge rounds of the c backend
+release the GIL. The task is an async iterator of the stats.Progress tuples
+of the call and can be awaited for its result:
+
+    task = qm.simplify_task(ones, dc)
+    async for p in task:
+        print(p.phase, p.round, p.n_primes)
+    res = await task
+
+cancel() cuts the call short at its next progress report, i.e. after the
+current merge round (with the c backend: before the next merge round or
+within the current one, every 65536 terms) or within the cover search; the
+result is then the valid cover found so far, as with QuineMcCluskey.cancel.
+Cancelling an asyncio task which awaits the SimplifyTask or iterates over it
+cancels the call as well.
+"""
+
+from __future__ import print_function
+import asyncio
+import threading
+
+
+
+class SimplifyTask:
+    """A call of simplify running in an executor.
+
+    After the call, n_bits, status and stats hold the results of the call
+    (see QuineMcCluskey); the profile counters are in stats.
+    """
+
+
+
+    def __init__(self, qm, ones, dc, num_bits, deadline, max_primes, executor = None):
+        """The class constructor. It must be called in a running event loop.
+
+        Args:
+            qm (QuineMcCluskey): the instance which does the work.
+            ones, dc, num_bits, deadline, max_primes: see
+            QuineMcCluskey.simplify.
+
+        Kwargs:
+            executor (concurrent.futures.Executor): the executor, or None for
+            the default executor of the loop.
+        """
+        self.n_bits = None
+        self.status = None
+        self.stats = None
+        self.__loop = asyncio.get_running_loop()
+        self.__events = asyncio.Queue()
+        self.__stop = threading.Event()
+        self.__future = self.__loop.run_in_executor(
+                executor, self.__run, qm, ones, dc, num_bits, deadline, max_primes)
+
+
+
+    def cancel(self):
+        """Cancel the call; it returns with status 'cancelled'."""
+        self.__stop.set()
+
+
+
+    def done(self):
+        """Return True if the call has returned."""
+        return self.__future.done()
+
+
+
+    def __run(self, qm, ones, dc, num_bits, deadline, max_primes):
+        """Run the call; this is the function executed by the executor."""
+        try:
+            res = qm.simplify(ones, dc, num_bits, deadline = deadline, max_primes = max_primes,
+                              progress = self.__report)
+            self.n_bits = qm.n_bits
+            self.status = qm.status
+            self.stats = qm.stats
+            return res
+        finally:
+            self.__loop.call_soon_threadsafe(self.__events.put_nowait, None)
+
+
+
+    def __report(self, event):
+        """The progress callable of the call, run in the executor."""
+        self.__loop.call_soon_threadsafe(self.__events.put_nowait, event)
+        return self.__stop.is_set()
+
+
+
+    def __aiter__(self):
+        return self
+
+
+
+    async def __anext__(self):
+        """Return the next stats.Progress of the call."""
+        try:
+            event = await self.__events.get()
+        except asyncio.CancelledError:
+            self.cancel()
+            raise
+        if event is None:
+            # Keep the end marker for the next iteration.
+            self.__events.put_nowait(None)
+            raise StopAsyncIteration
+        return event
+
+
+
+    def __await__(self):
+        return self.__result().__await__()
+
+
+
+    async def __result(self):
+        """Wait for the result of the call."""
+        try:
+            return await asyncio.shield(self.__future)
+        except asyncio.CancelledError:
+            self.cancel()
+            raise
@@ -0,0 +1,310 @@
+#  cache.py -- A result cache for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""A memoizing cache for the results of QuineMcCluskey.simplify.
+
+The cache is keyed on a hash of the canonical form of the ON-set and the
+DC-set, the number of bits, the use_xor flag and the other options of the
+instance which influence the result. The canonical form
+complements each input whose cofactor weights suggest it and sorts the inputs
+by their weights. Functions which differ only by a permutation or
+complementation of their inputs therefore usually share a cache entry, and the
+cached cover is mapped back to the inputs of the caller. A mapped cover has the
+same number of terms as a freshly computed one, but a different choice among
+equally sized covers is possible.
+
+Entries are kept in memory in least-recently-used order within a byte budget,
+and optionally in a persistent dbm database on disk.
+
+Example:
+    from quine_mccluskey.qm import QuineMcCluskey
+    from quine_mccluskey.cache import ResultCache
+    qm = QuineMcCluskey(cache = ResultCache(path = 'qm-cache.db'))
+"""
+
+from __future__ import print_function
+import collections
+import hashlib
+import sys
+import threading
+
+
+
+class ResultCache:
+    """The result cache.
+
+    One instance can be shared by several QuineMcCluskey instances.
+    """
+
+
+
+    def __init__(self, max_bytes = 64 * 1024 * 1024, path = None, canonical = True):
+        """The class constructor.
+
+        Kwargs:
+            max_bytes (int): the approximate maximum size of the entries held
+            in memory.
+
+            path (str): the file name of a persistent dbm database, or None
+            to keep the entries only in memory.
+
+            canonical (bool): if True, share entries between functions which
+            differ only by a permutation or complementation of the inputs.
+        """
+        self.max_bytes = max_bytes
+        self.canonical = canonical
+        self.n_bytes = 0
+        self.hits = 0
+        self.misses = 0
+        self.entries = collections.OrderedDict()
+        self.lock = threading.Lock()
+        self.db = None
+        if path is not None:
+            import dbm
+            self.db = dbm.open(path, 'c')
+
+
+
+    def close(self):
+        """Close the persistent database."""
+        with self.lock:
+            if self.db is not None:
+                self.db.close()
+                self.db = None
+
+
+
+    def get_or_compute(self, ones, dc, n_bits, use_xor, compute, cacheable = None, options = ""):
+        """Return the cached result or compute and store it.
+
+        Args:
+            ones (set of int): the minterms of the ON-set.
+            dc (set of int): the don't care minterms.
+            n_bits (int): the number of bits.
+            use_xor (bool): whether XOR and XNOR operators are used.
+            compute (callable): called without arguments to compute the result
+            on a cache miss.
+
+        Kwargs:
+            cacheable (callable): called without arguments after compute; the
+            result is only stored if it returns True.
+
+            options (str): the other settings which influence the result,
+            e.g. the method and the backend; they are part of the key.
+
+        Returns:
+            The result, as set of strings (see QuineMcCluskey.simplify_los).
+        """
+        entry = self.entry(ones, dc, n_bits, use_xor, options)
+        res = self.lookup(entry)
+        if res is not None:
+            return res
+
+        res = compute()
+        if res is not None and (cacheable is None or cacheable()):
+            self.store(entry, res)
+        return res
+
+
+
+    def entry(self, ones, dc, n_bits, use_xor, options = ""):
+        """Return the entry of a function, for lookup and store.
+
+        Args:
+            ones, dc, n_bits, use_xor: see get_or_compute.
+
+        Kwargs:
+            options (str): see get_or_compute.
+
+        Returns:
+            A tuple whose first item is the key of the function: it is the
+            same for all functions which share a cache entry.
+        """
+        if self.canonical:
+            transform = self.__get_transform(ones, dc, n_bits)
+        else:
+            transform = (list(range(n_bits)), 0)
+        c_ones = sorted(self.__map_minterm(m, transform) for m in ones)
+        c_dc = sorted(self.__map_minterm(m, transform) for m in dc)
+        digest = hashlib.sha256(repr((c_ones, c_dc)).encode()).hexdigest()
+        key = "%d:%d:%s:%s" % (n_bits, 1 if use_xor else 0, options, digest)
+        return key, transform, n_bits
+
+
+
+    def lookup(self, entry):
+        """Look up a result without computing it on a miss.
+
+        Args:
+            entry (tuple): the entry of the function, see entry.
+
+        Returns:
+            The cached result, mapped to the inputs of the function, or None.
+        """
+        key, transform, n_bits = entry
+        c_res = self.__lookup(key)
+        if c_res is None:
+            return None
+        return set(self.__unmap_term(t, transform, n_bits) for t in c_res)
+
+
+
+    def store(self, entry, res):
+        """Store the result of a function.
+
+        Args:
+            entry (tuple): the entry of the function, see entry.
+            res (set of str): the result; it must be that of a call which
+            ran to completion.
+        """
+        key, transform, n_bits = entry
+        self.__store(key, frozenset(self.__map_term(t, transform, n_bits) for t in res))
+
+
+
+    def __lookup(self, key):
+        """Look up key in memory and in the persistent database."""
+        with self.lock:
+            if key in self.entries:
+                self.entries.move_to_end(key)
+                self.hits += 1
+                return self.entries[key]
+            if self.db is not None and key.encode() in self.db:
+                value = self.db[key.encode()].decode()
+                res = frozenset(value.split('\n')) if value else frozenset()
+                self.__insert(key, res)
+                self.hits += 1
+                return res
+            self.misses += 1
+            return None
+
+
+
+    def __store(self, key, res):
+        """Store the canonical result res under key."""
+        with self.lock:
+            self.__insert(key, res)
+            if self.db is not None:
+                self.db[key.encode()] = '\n'.join(sorted(res)).encode()
+
+
+
+    def __insert(self, key, res):
+        """Insert an entry in memory and evict the least recently used ones."""
+        if key in self.entries:
+            return
+        self.entries[key] = res
+        self.n_bytes += self.__entry_size(key, res)
+        while self.n_bytes > self.max_bytes and len(self.entries) > 1:
+            old_key, old_res = self.entries.popitem(last=False)
+            self.n_bytes -= self.__entry_size(old_key, old_res)
+
+
+
+    def __entry_size(self, key, res):
+        """Estimate the memory used by an entry."""
+        return sys.getsizeof(key) + sys.getsizeof(res) + sum(sys.getsizeof(t) for t in res)
+
+
+
+    def __get_transform(self, ones, dc, n_bits):
+        """Calculate the input permutation and complementation.
+
+        Returns:
+            A tuple (pos, flip): pos[i] is the canonical bit position of the
+            input bit i, flip is the mask of the complemented inputs.
+
+        An input is complemented if fewer than half of the ON-set minterms
+        (or, on a tie, of the DC-set minterms) have the bit set. The inputs
+        are then sorted by these weights, ties are kept in input order.
+        """
+        on_weight = [0] * n_bits
+        dc_weight = [0] * n_bits
+        for m in ones:
+            for i in range(n_bits):
+                on_weight[i] += m >> i & 1
+        for m in dc:
+            for i in range(n_bits):
+                dc_weight[i] += m >> i & 1
+        flip = 0
+        for i in range(n_bits):
+            if 2 * on_weight[i] < len(ones) or \
+                    (2 * on_weight[i] == len(ones) and 2 * dc_weight[i] < len(dc)):
+                flip |= 1 << i
+                on_weight[i] = len(ones) - on_weight[i]
+                dc_weight[i] = len(dc) - dc_weight[i]
+        order = sorted(range(n_bits), key=lambda i: (on_weight[i], dc_weight[i]), reverse=True)
+        pos = [0] * n_bits
+        for rank, i in enumerate(order):
+            pos[i] = n_bits - 1 - rank
+        return pos, flip
+
+
+
+    def __map_minterm(self, m, transform):
+        """Map a minterm to the canonical inputs."""
+        pos, flip = transform
+        m ^= flip
+        res = 0
+        for i, p in enumerate(pos):
+            res |= (m >> i & 1) << p
+        return res
+
+
+
+    def __map_term(self, term, transform, n_bits):
+        """Map a result term (as string) to the canonical inputs."""
+        return self.__transform_term(term, transform, n_bits, True)
+
+
+
+    def __unmap_term(self, term, transform, n_bits):
+        """Map a canonical result term (as string) back to the inputs."""
+        return self.__transform_term(term, transform, n_bits, False)
+
+
+
+    def __transform_term(self, term, transform, n_bits, forward):
+        """Permute and complement the characters of a term.
+
+        Character k of a term stands for bit n_bits - 1 - k. A complemented
+        input swaps '0' and '1'; an odd number of complemented inputs in a
+        XOR (XNOR) group turns it into a XNOR (XOR) group.
+        """
+        pos, flip = transform
+        res = list(term)
+        n_flipped_xors = 0
+        for i, p in enumerate(pos):
+            src, dst = (i, p) if forward else (p, i)
+            c = term[n_bits - 1 - src]
+            if flip >> i & 1:
+                if c == '0':
+                    c = '1'
+                elif c == '1':
+                    c = '0'
+                elif c in '^~':
+                    n_flipped_xors += 1
+            res[n_bits - 1 - dst] = c
+        if n_flipped_xors % 2:
+            res = [{'^': '~', '~': '^'}.get(c, c) for c in res]
+        return "".join(res)
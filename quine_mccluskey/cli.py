@@ -0,0 +1,424 @@
+#  cli.py -- The qm command line tool
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+
+"""The qm command line tool.
+
+qm reads boolean functions from files or from stdin, minimises them and
+writes one result per function as soon as it is done:
+
+    qm [options] [file ...]
+
+The input formats are:
+
+    pla     the Berkeley PLA format of espresso: .i, .o, .ilb, .ob, .type
+            (f, fd, fr or fdr) and one cube per line, e.g. "1-0 1". Each
+            output is a separate function.
+    blif    the .names tables of a BLIF model whose inputs are all primary
+            inputs, e.g. ".names a b f" followed by "1- 1". Each table is a
+            separate function; a table of '0' rows gives the OFF-set.
+    json    an object {"ones": [...], "dc": [...], "n_bits": n, "name": s}
+            or a list of such objects; only ones is required.
+    qmtt    a truth table file (see quine_mccluskey.truthtable).
+
+The format is taken from the file name extension (.pla, .blif, .json,
+.qmtt) or, for other names and stdin, guessed from the contents. The first
+character of a cube is the most significant bit, as in the results.
+
+Each result is written as "name: term term ...", or with --json as one JSON
+object per line. --jobs distributes the functions over worker processes.
+--verify checks each result against its function and reports the minterms
+which are wrong on stderr.
+
+Example:
+    qm --xor --jobs 4 --stats adder.pla mux.blif
+"""
+
+from __future__ import print_function
+import argparse
+import json
+import multiprocessing
+import os
+import sys
+from .qm import QuineMcCluskey
+from . import truthtable
+
+
+formats = ("pla", "blif", "json", "qmtt")
+
+
+
+def _cube_minterms(cube, name):
+    """Iterator over the minterms of a cube of '0', '1' and '-' characters."""
+    value = 0
+    mask = 0
+    for c in cube:
+        value <<= 1
+        mask <<= 1
+        if c == '1':
+            value |= 1
+        elif c in '-2':
+            mask |= 1
+        elif c != '0':
+            raise ValueError("%s: invalid character '%s' in cube '%s'" % (name, c, cube))
+    sub = 0
+    while True:
+        yield value | sub
+        sub = (sub - mask) & mask
+        if sub == 0:
+            break
+
+
+
+def _lines(text):
+    """Iterator over the lines of text without comments and blank lines."""
+    for line in text.splitlines():
+        line = line.split('#', 1)[0].strip()
+        if line:
+            yield line
+
+
+
+def read_pla(text, name):
+    """Read the functions of a PLA file.
+
+    Args:
+        text (str): the contents of the file.
+        name (str): the name of the file, for the function names and the
+        error messages.
+
+    Returns:
+        A list of tuples (name, ones, dc, n_bits), one for each output.
+    """
+    n_in = n_out = None
+    labels = None
+    pla_type = "fd"
+    rows = []
+    for line in _lines(text):
+        if line.startswith('.'):
+            words = line.split()
+            if words[0] == '.i':
+                n_in = int(words[1])
+            elif words[0] == '.o':
+                n_out = int(words[1])
+            elif words[0] == '.ob':
+                labels = words[1:]
+            elif words[0] == '.type':
+                pla_type = words[1]
+                if pla_type not in ("f", "fd", "fr", "fdr"):
+                    raise ValueError("%s: unsupported .type %s" % (name, pla_type))
+            elif words[0] in ('.e', '.end'):
+                break
+            continue
+        fields = line.split()
+        if len(fields) == 1 and n_in is not None:
+            fields = [line[:n_in], line[n_in:]]
+        if len(fields) != 2:
+            raise ValueError("%s: invalid line '%s'" % (name, line))
+        rows.append(fields)
+    if n_in is None:
+        n_in = len(rows[0][0]) if rows else 0
+    if n_out is None:
+        n_out = len(rows[0][1]) if rows else 0
+    if labels is None or len(labels) != n_out:
+        labels = [str(k) for k in range(n_out)]
+
+    ones = [set() for k in range(n_out)]
+    dc = [set() for k in range(n_out)]
+    off = [set() for k in range(n_out)]
+    for cube, outputs in rows:
+        if len(cube) != n_in or len(outputs) != n_out:
+            raise ValueError("%s: '%s %s' does not match .i %d .o %d" % (name, cube, outputs, n_in, n_out))
+        minterms = list(_cube_minterms(cube, name))
+        for k, c in enumerate(outputs):
+            if c in '14':
+                ones[k].update(minterms)
+            elif c in '-2' and 'd' in pla_type:
+                dc[k].update(minterms)
+            elif c == '0' and 'r' in pla_type:
+                off[k].update(minterms)
+    if 'r' in pla_type:
+        # Everything which is neither ON nor OFF is a don't care.
+        for k in range(n_out):
+            dc[k] = set(m for m in range(1 << n_in) if m not in ones[k] and m not in off[k]) | dc[k]
+    if n_out == 1:
+        return [(name, ones[0], dc[0], n_in)]
+    return [("%s:%s" % (name, labels[k]), ones[k], dc[k], n_in) for k in range(n_out)]
+
+
+
+def read_blif(text, name):
+    """Read the functions of a BLIF file.
+
+    Args:
+        text (str): the contents of the file.
+        name (str): see read_pla.
+
+    Returns:
+        A list of tuples (name, ones, dc, n_bits), one for each .names table.
+        The bits are the inputs of the table, the first one the most
+        significant bit.
+    """
+    # Join the continued lines first.
+    text = text.replace('\\\n', ' ')
+    inputs = None
+    tables = []
+    for line in _lines(text):
+        words = line.split()
+        if words[0] == '.inputs':
+            inputs = (inputs or []) + words[1:]
+        elif words[0] == '.names':
+            if len(words) < 2:
+                raise ValueError("%s: .names without output" % name)
+            tables.append((words[1:-1], words[-1], []))
+        elif words[0] == '.end':
+            break
+        elif words[0].startswith('.'):
+            tables.append(None)
+        elif tables and tables[-1] is not None:
+            tables[-1][2].append(words)
+        else:
+            raise ValueError("%s: invalid line '%s'" % (name, line))
+
+    res = []
+    for table in tables:
+        if table is None:
+            continue
+        table_inputs, output, rows = table
+        if inputs is not None and any(i not in inputs for i in table_inputs):
+            raise ValueError("%s: the inputs of %s are not all primary inputs" % (name, output))
+        n_bits = len(table_inputs)
+        ones = set()
+        phase = None
+        for row in rows:
+            if n_bits == 0 and len(row) == 1:
+                row = ['', row[0]]
+            if len(row) != 2 or len(row[0]) != n_bits or row[1] not in '01':
+                raise ValueError("%s: invalid row '%s' of %s" % (name, ' '.join(row), output))
+            if phase is not None and row[1] != phase:
+                raise ValueError("%s: mixed ON and OFF rows in %s" % (name, output))
+            phase = row[1]
+            ones.update(_cube_minterms(row[0], name))
+        if phase == '0':
+            ones = set(range(1 << n_bits)) - ones
+        res.append(("%s:%s" % (name, output), ones, set(), n_bits))
+    return res
+
+
+
+def read_json(text, name):
+    """Read the functions of a JSON file.
+
+    Args:
+        text (str): the contents of the file.
+        name (str): see read_pla.
+
+    Returns:
+        A list of tuples (name, ones, dc, n_bits); n_bits is None if it is
+        not given.
+    """
+    data = json.loads(text)
+    if isinstance(data, dict):
+        data = [data]
+    res = []
+    for k, f in enumerate(data):
+        if not isinstance(f, dict) or 'ones' not in f:
+            raise ValueError("%s: function %d has no ones" % (name, k))
+        f_name = f.get('name', name if len(data) == 1 else "%s:%d" % (name, k))
+        res.append((f_name, set(f['ones']), set(f.get('dc', [])), f.get('n_bits')))
+    return res
+
+
+
+def guess_format(path, text):
+    """Return the format of a file from its name or its contents."""
+    ext = os.path.splitext(path)[1].lstrip('.').lower()
+    if ext in formats:
+        return ext
+    if text is None:
+        return "qmtt"
+    start = text.lstrip()[:1]
+    if start in ('{', '['):
+        return "json"
+    if any(line.split()[0] in ('.model', '.names', '.inputs') for line in _lines(text)):
+        return "blif"
+    return "pla"
+
+
+
+def read_functions(path, fmt = None):
+    """Read the functions of a file.
+
+    Args:
+        path (str): the file name, or '-' for stdin.
+
+    Kwargs:
+        fmt (str): one of formats, or None to guess it (see guess_format).
+
+    Returns:
+        A list of tuples (name, ones, dc, n_bits). For qmtt files, ones is
+        the file name and dc and n_bits are None; the table is read by the
+        worker.
+    """
+    if path == '-':
+        name = "<stdin>"
+        text = sys.stdin.read()
+    else:
+        name = path
+        with open(path, 'rb') as f:
+            # Truth tables are left to the worker, which maps the file.
+            magic = f.read(len(truthtable.MAGIC))
+            if fmt == "qmtt" or magic == truthtable.MAGIC:
+                text = None
+            else:
+                text = (magic + f.read()).decode()
+    if fmt is None:
+        fmt = guess_format(path, text)
+    if fmt == "qmtt":
+        if path == '-':
+            raise ValueError("truth table files cannot be read from stdin")
+        return [(name, path, None, None)]
+    readers = dict(pla = read_pla, blif = read_blif, json = read_json)
+    return readers[fmt](text, name)
+
+
+
+def _init_worker(config):
+    """Create the QuineMcCluskey instance of a worker."""
+    global _worker_qm
+    _worker_qm = QuineMcCluskey(**config)
+
+
+
+def _simplify_task(task):
+    """Simplify one function.
+
+    Args:
+        task (tuple): (name, ones, dc, n_bits, deadline, verify); see
+        read_functions.
+
+    Returns:
+        A dict with the name, the sorted result terms, the status and the
+        statistics of the call, and with verify the wrong minterms. If a
+        truth table file cannot be read, the dict has the name and the
+        error message only.
+    """
+    name, ones, dc, n_bits, deadline, verify = task
+    qm = _worker_qm
+    if dc is None:
+        try:
+            res = qm.simplify_file(ones, deadline = deadline, verify = verify)
+        except (IOError, OSError, ValueError) as e:
+            return dict(name = name, error = str(e))
+    else:
+        res = qm.simplify(ones, dc, num_bits = n_bits, deadline = deadline, verify = verify)
+    r = dict(name = name, terms = sorted(res) if res is not None else [],
+             status = qm.status, stats = qm.stats.as_dict())
+    if verify:
+        r['mismatches'] = list(qm.stats.mismatches or [])
+    return r
+
+
+
+def main(argv = None):
+    """The entry point of the qm command.
+
+    Kwargs:
+        argv (list of str): the arguments, without the program name. The
+        default is sys.argv[1:].
+
+    Returns:
+        The exit status: 0 on success, 1 if an input could not be read, 2 if
+        a result failed the check of --verify. Truth table files are read
+        by the workers; the other inputs are still simplified if one of
+        them cannot be read.
+    """
+    parser = argparse.ArgumentParser(prog = "qm", description = "Minimise boolean functions.")
+    parser.add_argument("files", nargs = "*", default = ["-"],
+                        help = "the input files, '-' for stdin (default)")
+    parser.add_argument("-f", "--format", choices = formats,
+                        help = "the format of the inputs (default: from the file name or contents)")
+    parser.add_argument("-j", "--jobs", type = int, default = 1,
+                        help = "the number of worker processes")
+    parser.add_argument("--xor", action = "store_true", help = "use XOR and XNOR operators")
+    parser.add_argument("--deadline", type = float,
+                        help = "the maximum time in seconds for each function")
+    parser.add_argument("--backend", choices = QuineMcCluskey.backends, help = "the prime implicant backend")
+    parser.add_argument("--method", choices = QuineMcCluskey.methods, default = "qm",
+                        help = "the minimisation method")
+    parser.add_argument("--stats", action = "store_true",
+                        help = "report the statistics of each function")
+    parser.add_argument("--json", action = "store_true", help = "write one JSON object per result")
+    parser.add_argument("--verify", action = "store_true",
+                        help = "check each result against its function")
+    args = parser.parse_args(argv)
+
+    tasks = []
+    for path in args.files:
+        try:
+            functions = read_functions(path, args.format)
+        except (IOError, OSError, ValueError) as e:
+            print("qm: %s" % e, file = sys.stderr)
+            return 1
+        for name, ones, dc, n_bits in functions:
+            tasks.append((name, ones, dc, n_bits, args.deadline, args.verify))
+
+    config = dict(use_xor = args.xor, backend = args.backend, method = args.method)
+    if args.jobs > 1 and len(tasks) > 1:
+        pool = multiprocessing.Pool(args.jobs, _init_worker, (config,))
+        results = pool.imap_unordered(_simplify_task, tasks)
+    else:
+        pool = None
+        _init_worker(config)
+        results = (_simplify_task(t) for t in tasks)
+    status = 0
+    try:
+        for r in results:
+            if 'error' in r:
+                print("qm: %s" % r['error'], file = sys.stderr)
+                status = status or 1
+                continue
+            if r.get('mismatches'):
+                print("qm: %s: the result is wrong for the minterms %s" % (
+                    r['name'], " ".join(str(m) for m in r['mismatches'])), file = sys.stderr)
+                status = 2
+            if not args.stats:
+                del r['stats']
+            if args.json:
+                print(json.dumps(r, sort_keys = True))
+            else:
+                print("%s: %s" % (r['name'], " ".join(r['terms'])))
+                if args.stats:
+                    st = r['stats']
+                    print("%s: %s, %.4f s, %d primes, %d terms" % (
+                        r['name'], r['status'], st['wall_time'], st['n_primes'], st['n_terms']),
+                        file = sys.stderr)
+            sys.stdout.flush()
+    finally:
+        if pool is not None:
+            pool.close()
+            pool.join()
+    return status
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,308 @@
+#  cover.py -- An exact set covering solver for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""An exact solver for the unate covering problem.
+
+The covering problem is given as a sparse matrix of rows (the minterms of the
+ON-set) and columns (the implicants). Each column is an integer bitset of the
+rows it covers and has a cost. The solver looks for a set of columns of
+minimum total cost which covers all rows.
+
+The matrix is first reduced by extracting essential columns and removing
+dominated rows and columns. The remaining cyclic core is solved by
+branch-and-bound, which re-applies the reductions at each node and prunes
+with a lower bound derived from a set of independent rows.
+"""
+
+from __future__ import print_function
+import heapq
+import time
+
+
+
+def _bits(x):
+    """Iterator over the positions of the bits set in x."""
+    while x:
+        low = x & -x
+        yield low.bit_length() - 1
+        x ^= low
+
+
+
+def _popcount(i):
+    """Return the number of bits set in the non-negative integer i."""
+    return bin(i).count('1')
+
+
+
+class CoverSolver:
+    """The set covering solver.
+
+    The search stops after time_budget seconds (if not None) or when the
+    stop event is set, and returns the best cover found so far.
+    """
+    max_depth = 500         # maximum recursion depth of the search
+    progress_nodes = 256    # the number of nodes between progress calls
+
+
+
+    def __init__(self, columns, costs, time_budget = None, stop = None, progress = None):
+        """The class constructor.
+
+        Args:
+            columns (list of int): the rows covered by each column as bitset.
+            costs (list of int): the cost of each column.
+
+        Kwargs:
+            time_budget (float): the maximum time in seconds spent in the
+            branch-and-bound search, or None for no limit.
+
+            stop (threading.Event): an optional event which stops the search
+            when it is set, e.g. from another thread.
+
+            progress (callable): called with the number of nodes searched so
+            far every progress_nodes nodes.
+        """
+        self.columns = columns
+        self.costs = costs
+        self.time_budget = time_budget
+        self.stop = stop
+        self.progress = progress
+        self.deadline = None
+        self.best_cost = None
+        self.best_cover = None
+        self.optimal = True
+        self.n_nodes = 0
+
+
+
+    def solve(self, rows, initial = None):
+        """Solve the covering problem.
+
+        Args:
+            rows (int): the bitset of the rows to cover.
+
+        Kwargs:
+            initial (list of int): the indexes of the columns of a known valid
+            cover, used as the initial upper bound.
+
+        Returns:
+            A tuple (cover, optimal) of the list of the chosen column indexes
+            and a flag which is False if the search was stopped by the time
+            budget or the stop event before the optimum was proven. cover is
+            None if the rows cannot be covered.
+        """
+        if self.time_budget is not None:
+            self.deadline = time.time() + self.time_budget
+        if initial is not None:
+            self.best_cover = sorted(initial)
+            self.best_cost = sum(self.costs[c] for c in initial)
+        cols = 0
+        for c in range(len(self.columns)):
+            if self.columns[c] & rows:
+                cols |= 1 << c
+        # A greedy cover gives a first upper bound for the search.
+        self.__complete_greedy(rows, cols, 0, [])
+        self.__search(rows, cols, 0, [])
+        return self.best_cover, self.optimal
+
+
+
+    def __expired(self):
+        """Return True if the time budget is exhausted or the stop event set."""
+        return (self.deadline is not None and time.time() > self.deadline) or \
+                (self.stop is not None and self.stop.is_set())
+
+
+
+    def __row_columns(self, rows, cols):
+        """Build the transposed matrix: the columns covering each row."""
+        row_cols = dict((r, 0) for r in _bits(rows))
+        for c in _bits(cols):
+            bit = 1 << c
+            for r in _bits(self.columns[c] & rows):
+                row_cols[r] |= bit
+        return row_cols
+
+
+
+    def __reduce(self, rows, cols, cost, cover):
+        """Apply the essential column, row and column dominance reductions.
+
+        Returns:
+            A tuple (rows, cols, cost, cover, row_cols) of the reduced problem,
+            or None if a row cannot be covered by any remaining column or if
+            the search ran out of time.
+        """
+        while True:
+            if self.__expired():
+                self.optimal = False
+                return None
+            row_cols = self.__row_columns(rows, cols)
+            changed = False
+
+            # Essential columns: a row covered by one single column.
+            for r in list(row_cols):
+                rc = row_cols[r]
+                if rc == 0:
+                    return None
+                if rows >> r & 1 and rc & (rc - 1) == 0:
+                    c = rc.bit_length() - 1
+                    cover = cover + [c]
+                    cost += self.costs[c]
+                    rows &= ~self.columns[c]
+                    cols &= ~rc
+                    changed = True
+            if changed:
+                continue
+
+            # Row dominance: if every column covering r1 also covers r2, then
+            # r2 is covered whenever r1 is.
+            for r1 in sorted(row_cols, key=lambda r: _popcount(row_cols[r])):
+                if not rows >> r1 & 1:
+                    continue
+                rc1 = row_cols[r1]
+                c = rc1.bit_length() - 1
+                for r2 in _bits(self.columns[c] & rows):
+                    if r2 != r1 and rc1 & ~row_cols[r2] == 0:
+                        rows &= ~(1 << r2)
+                        changed = True
+            if changed:
+                continue
+
+            # Column dominance: a column whose rows are a subset of the rows
+            # of a column that is not more expensive can be removed.
+            for c1 in _bits(cols):
+                if self.__expired():
+                    self.optimal = False
+                    return None
+                cov1 = self.columns[c1] & rows
+                if cov1 == 0:
+                    cols &= ~(1 << c1)
+                    changed = True
+                    continue
+                for c2 in _bits(row_cols[cov1.bit_length() - 1] & cols):
+                    if c2 == c1:
+                        continue
+                    cov2 = self.columns[c2] & rows
+                    if cov1 & ~cov2 == 0 and self.costs[c2] <= self.costs[c1] and \
+                            (cov1 != cov2 or self.costs[c2] < self.costs[c1] or c2 < c1):
+                        cols &= ~(1 << c1)
+                        changed = True
+                        break
+            if not changed:
+                return rows, cols, cost, cover, row_cols
+
+
+
+    def __lower_bound(self, rows, cols, row_cols):
+        """Calculate a lower bound of the cost to cover rows.
+
+        Two bounds are combined. Rows which have no covering column in common
+        need distinct columns, so the sum of their cheapest columns is a lower
+        bound. And each row has to pay at least the smallest cost per covered
+        row among its columns.
+        """
+        ratio = {}
+        for c in _bits(cols):
+            n = _popcount(self.columns[c] & rows)
+            if n:
+                ratio[c] = float(self.costs[c]) / n
+        independent = 0
+        fractional = 0.0
+        taken = 0
+        for r in sorted(_bits(rows), key=lambda r: _popcount(row_cols[r])):
+            rc = row_cols[r]
+            fractional += min(ratio[c] for c in _bits(rc))
+            if rc & taken == 0:
+                taken |= rc
+                independent += min(self.costs[c] for c in _bits(rc))
+        return max(independent, fractional - 1e-9 * fractional)
+
+
+
+    def __search(self, rows, cols, cost, cover):
+        """The branch-and-bound search."""
+        self.n_nodes += 1
+        if self.progress is not None and self.n_nodes % self.progress_nodes == 0:
+            self.progress(self.n_nodes)
+        if self.__expired() or len(cover) >= self.max_depth:
+            # Out of time (or stack): keep the best cover found so far.
+            self.optimal = False
+            if self.best_cost is None:
+                self.__complete_greedy(rows, cols, cost, cover)
+            return
+        reduced = self.__reduce(rows, cols, cost, cover)
+        if reduced is None:
+            return
+        rows, cols, cost, cover, row_cols = reduced
+        if rows == 0:
+            if self.best_cost is None or cost < self.best_cost:
+                self.best_cost = cost
+                self.best_cover = sorted(cover)
+            return
+        if self.best_cost is not None and cost + self.__lower_bound(rows, cols, row_cols) >= self.best_cost:
+            return
+
+        # Branch on the columns of the row with the fewest alternatives,
+        # trying the columns with the lowest cost per covered row first.
+        live = [r for r in row_cols if rows >> r & 1]
+        branch_row = min(live, key=lambda r: (_popcount(row_cols[r]), r))
+        candidates = sorted(_bits(row_cols[branch_row] & cols),
+                key=lambda c: (float(self.costs[c]) / _popcount(self.columns[c] & rows), c))
+        for c in candidates:
+            self.__search(rows & ~self.columns[c], cols & ~(1 << c), cost + self.costs[c], cover + [c])
+            # The following branches do not use column c.
+            cols &= ~(1 << c)
+
+
+
+    def __complete_greedy(self, rows, cols, cost, cover):
+        """Complete a partial cover by greedily choosing the cheapest columns.
+
+        The cost per covered row of a column can only grow as rows get
+        covered, so the columns are kept in a heap and re-evaluated lazily.
+        """
+        heap = []
+        for c in _bits(cols):
+            n = _popcount(self.columns[c] & rows)
+            if n:
+                heap.append((float(self.costs[c]) / n, c))
+        heapq.heapify(heap)
+        while rows:
+            if not heap:
+                return
+            ratio, c = heapq.heappop(heap)
+            n = _popcount(self.columns[c] & rows)
+            if n == 0:
+                continue
+            current = float(self.costs[c]) / n
+            if current > ratio and heap and (current, c) > heap[0]:
+                heapq.heappush(heap, (current, c))
+                continue
+            cover = cover + [c]
+            cost += self.costs[c]
+            rows &= ~self.columns[c]
+        if self.best_cost is None or cost < self.best_cost:
+            self.best_cost = cost
+            self.best_cover = sorted(cover)
@@ -0,0 +1,172 @@
+#  cubeindex.py -- A ternary trie of implicants for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""An index of implicants for coverage and containment queries.
+
+The implicants are packed terms (value, mask, xor_mask, xnor_mask) as in
+qm.py. They are stored in a ternary trie which branches on one bit per
+level, from the most significant bit down: code 0 and 1 for a fixed '0' or
+'1', code 2 for a free bit ('-', '^' or '~'). A query follows only the
+branches which are compatible with its argument, so its cost depends on the
+depth of the trie and the number of matching branches, not on the number of
+minterms of the implicants.
+
+The XOR and XNOR bits of an implicant are free bits in the trie. covering
+checks their parity; the cube queries treat them as '-'.
+"""
+
+from __future__ import print_function
+
+
+_FREE = 2
+
+
+
+class CubeIndex:
+    """The ternary trie."""
+
+
+
+    def __init__(self, n_bits, terms = ()):
+        """The class constructor.
+
+        Args:
+            n_bits (int): the number of bits of the terms.
+
+        Kwargs:
+            terms (iterable of tuple): the packed terms to add.
+        """
+        self.n_bits = n_bits
+        self.root = self.__new_node(0)
+        self.n_terms = 0
+        for t in terms:
+            self.add(t)
+
+
+
+    def __len__(self):
+        """Return the number of terms in the index."""
+        return self.n_terms
+
+
+
+    def __new_node(self, depth):
+        """An inner node is a list of 3 children, a leaf a set of terms."""
+        return set() if depth == self.n_bits else [None, None, None]
+
+
+
+    def __codes(self, term):
+        """Iterator over the trie codes of a term, most significant bit first."""
+        value, mask, xor_mask, xnor_mask = term
+        free = mask | xor_mask | xnor_mask
+        for b in range(self.n_bits - 1, -1, -1):
+            yield _FREE if free >> b & 1 else value >> b & 1
+
+
+
+    def add(self, term):
+        """Add a packed term to the index."""
+        node = self.root
+        for depth, code in enumerate(self.__codes(term)):
+            if node[code] is None:
+                node[code] = self.__new_node(depth + 1)
+            node = node[code]
+        if term not in node:
+            node.add(term)
+            self.n_terms += 1
+
+
+
+    def discard(self, term):
+        """Remove a packed term from the index if it is contained."""
+        node = self.root
+        for code in self.__codes(term):
+            node = node[code]
+            if node is None:
+                return
+        if term in node:
+            node.remove(term)
+            self.n_terms -= 1
+
+
+
+    def __search(self, allowed):
+        """Iterator over the terms of the leaves reachable with the codes.
+
+        Args:
+            allowed (list of tuple): the codes which may be followed at each
+            depth.
+        """
+        stack = [(self.root, 0)]
+        n_bits = self.n_bits
+        while stack:
+            node, depth = stack.pop()
+            if depth == n_bits:
+                for t in node:
+                    yield t
+                continue
+            for code in allowed[depth]:
+                child = node[code]
+                if child is not None:
+                    stack.append((child, depth + 1))
+
+
+
+    def __allowed(self, term, fixed_codes, free_codes):
+        """The codes to follow at each depth for the fixed and free bits of term."""
+        value, mask, xor_mask, xnor_mask = term
+        free = mask | xor_mask | xnor_mask
+        return [free_codes if free >> b & 1 else fixed_codes[value >> b & 1]
+                for b in range(self.n_bits - 1, -1, -1)]
+
+
+
+    def covering(self, m):
+        """Iterator over the terms which cover the minterm m."""
+        allowed = [(m >> b & 1, _FREE) for b in range(self.n_bits - 1, -1, -1)]
+        for t in self.__search(allowed):
+            xor_mask, xnor_mask = t[2], t[3]
+            if xor_mask and not bin(m & xor_mask).count('1') & 1:
+                continue
+            if xnor_mask and bin(m & xnor_mask).count('1') & 1:
+                continue
+            yield t
+
+
+
+    def supercubes(self, term):
+        """Iterator over the terms which contain the cube term."""
+        return self.__search(self.__allowed(term, ((0, _FREE), (1, _FREE)), (_FREE,)))
+
+
+
+    def subcubes(self, term):
+        """Iterator over the terms which are contained in the cube term."""
+        return self.__search(self.__allowed(term, ((0,), (1,)), (0, 1, _FREE)))
+
+
+
+    def intersecting(self, term):
+        """Iterator over the terms which agree with term on their common fixed bits."""
+        return self.__search(self.__allowed(term, ((0, _FREE), (1, _FREE)), (0, 1, _FREE)))
@@ -0,0 +1,251 @@
+#  heuristic.py -- An Espresso-style heuristic minimiser for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""A heuristic two-level minimiser in the style of Espresso.
+
+Instead of generating all prime implicants, a cover of cubes is improved
+iteratively:
+
+    EXPAND       each cube is grown into a prime implicant by freeing one
+                 fixed bit after the other, as long as the cube stays within
+                 the ON- and DC-set. Cubes which become covered are dropped.
+    IRREDUNDANT  cubes whose ON-set minterms are all covered by other cubes
+                 are removed, the least desirable first.
+    REDUCE       each cube is shrunk to the smallest cube containing the
+                 ON-set minterms which no other cube covers, so that the next
+                 EXPAND can grow it in a different direction.
+
+The loop stops when a REDUCE/EXPAND/IRREDUNDANT pass does not lower the cost
+of the cover. Cubes are packed terms (value, mask, 0, 0) as in qm.py; the
+ON- and DC-set are given explicitly, everything else is the OFF-set.
+"""
+
+from __future__ import print_function
+
+
+def _popcount(i):
+    """Return the number of bits set in the non-negative integer i."""
+    return bin(i).count('1')
+
+
+
+class Espresso:
+    """The heuristic minimiser."""
+    max_iterations = 20     # maximum number of REDUCE/EXPAND passes
+
+
+
+    def __init__(self, ones, dc, n_bits, rank, cost, stop = None):
+        """The class constructor.
+
+        Args:
+            ones (set of int): the ON-set minterms, disjoint from dc.
+            dc (set of int): the don't care minterms.
+            n_bits (int): the number of bits.
+            rank (callable): rank(cube, n) gives the desirability of a cube
+            covering n ON-set minterms; higher is better.
+            cost (callable): cost(cube) gives the complexity of a cube.
+
+        Kwargs:
+            stop (callable): called without arguments from time to time; the
+            minimisation ends with the current cover when it returns True.
+        """
+        self.ones = ones
+        self.care = ones | dc
+        self.n_bits = n_bits
+        self.all_bits = (1 << n_bits) - 1
+        self.rank = rank
+        self.cost = cost
+        self.stop = stop
+        self.on_cover = {}      # cube -> frozenset of covered ON minterms
+        self.primes = set()     # all prime implicants found by EXPAND
+
+
+
+    def minimize(self):
+        """Run the minimisation.
+
+        Returns:
+            A list of cubes which covers the ON-set and is contained in the
+            union of the ON- and the DC-set. All prime implicants met on the
+            way are collected in self.primes.
+        """
+        cover = [(m, 0, 0, 0) for m in sorted(self.ones)]
+        for c in cover:
+            self.on_cover[c] = frozenset([c[0]])
+        cover = self.__irredundant(self.__expand(cover))
+        best = list(cover)
+        best_cost = self.__cover_cost(best)
+        for i in range(self.max_iterations):
+            if self.__stopped():
+                break
+            cover = self.__irredundant(self.__expand(self.__reduce(cover)))
+            cost = self.__cover_cost(cover)
+            if cost >= best_cost:
+                break
+            best, best_cost = list(cover), cost
+        return best
+
+
+
+    def __stopped(self):
+        """Return True if the stop callable asks to stop."""
+        return self.stop is not None and self.stop()
+
+
+
+    def __cover_cost(self, cover):
+        """The cost of a cover: the number of cubes, then their complexity."""
+        return (len(cover), sum(self.cost(c) for c in cover))
+
+
+
+    def __minterms(self, cube):
+        """Iterator over all minterms of a cube."""
+        value, mask = cube[0], cube[1]
+        sub = 0
+        while True:
+            yield value | sub
+            sub = (sub - mask) & mask
+            if sub == 0:
+                break
+
+
+
+    def __in_care(self, cube):
+        """Return True if all minterms of cube are in the ON- or DC-set."""
+        if 1 << _popcount(cube[1]) > len(self.care):
+            return False
+        care = self.care
+        return all(m in care for m in self.__minterms(cube))
+
+
+
+    def __get_on_cover(self, cube):
+        """Return the ON-set minterms of a cube, as frozenset."""
+        if cube not in self.on_cover:
+            ones = self.ones
+            value, mask = cube[0], cube[1]
+            if 1 << _popcount(mask) <= len(ones):
+                res = frozenset(m for m in self.__minterms(cube) if m in ones)
+            else:
+                fixed = self.all_bits & ~mask
+                res = frozenset(m for m in ones if m & fixed == value)
+            self.on_cover[cube] = res
+        return self.on_cover[cube]
+
+
+
+    def __expand(self, cover):
+        """Grow each cube of the cover into a prime implicant.
+
+        The cubes are expanded starting with the most desirable one. Each
+        step frees the bit which adds the most ON-set minterms which are not
+        covered yet. Cubes whose ON-set minterms are covered by the cubes
+        expanded so far are dropped.
+        """
+        order = sorted(cover, key=lambda c: (-self.rank(c, len(self.__get_on_cover(c))), c))
+        covered = set()
+        res = []
+        for i, c in enumerate(order):
+            if self.__stopped():
+                # Keep the remaining cubes unchanged.
+                res.extend(d for d in order[i:] if not self.__get_on_cover(d) <= covered)
+                break
+            if self.__get_on_cover(c) <= covered:
+                continue
+            value, mask = c[0], c[1]
+            while True:
+                # Free the bit whose other half adds the most ON-set
+                # minterms which are not covered yet.
+                best = None
+                fixed = self.all_bits & ~mask
+                while fixed:
+                    bit = fixed & -fixed
+                    fixed ^= bit
+                    half = ((value ^ bit) & ~mask, mask, 0, 0)
+                    if self.__in_care(half):
+                        gain = len(self.__get_on_cover(half) - covered)
+                        if best is None or gain > best[0]:
+                            best = (gain, bit)
+                if best is None:
+                    break
+                value &= ~best[1]
+                mask |= best[1]
+            e = (value, mask, 0, 0)
+            covered |= self.__get_on_cover(e)
+            res.append(e)
+            self.primes.add(e)
+        return res
+
+
+
+    def __irredundant(self, cover):
+        """Remove cubes whose ON-set minterms are covered by other cubes.
+
+        The least desirable cubes are considered for removal first.
+        """
+        cover = sorted(set(cover))
+        count = {}
+        for c in cover:
+            for m in self.__get_on_cover(c):
+                count[m] = count.get(m, 0) + 1
+        res = set(cover)
+        for c in sorted(cover, key=lambda c: (self.rank(c, len(self.__get_on_cover(c))), c)):
+            cov = self.__get_on_cover(c)
+            if all(count[m] > 1 for m in cov):
+                res.discard(c)
+                for m in cov:
+                    count[m] -= 1
+        return sorted(res)
+
+
+
+    def __reduce(self, cover):
+        """Shrink each cube to the ON-set minterms only it covers.
+
+        The most desirable cubes are reduced first. A cube whose minterms
+        are all covered by other cubes is removed.
+        """
+        count = {}
+        for c in cover:
+            for m in self.__get_on_cover(c):
+                count[m] = count.get(m, 0) + 1
+        res = []
+        for c in sorted(cover, key=lambda c: (-self.rank(c, len(self.__get_on_cover(c))), c)):
+            cov = self.__get_on_cover(c)
+            unique = [m for m in cov if count[m] == 1]
+            if unique:
+                and_all = self.all_bits
+                or_all = 0
+                for m in unique:
+                    and_all &= m
+                    or_all |= m
+                r = (and_all, and_all ^ or_all, 0, 0)
+                res.append(r)
+                r_cov = self.__get_on_cover(r)
+            else:
+                r_cov = frozenset()
+            for m in cov - r_cov:
+                count[m] -= 1
+        return res
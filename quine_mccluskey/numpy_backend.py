@@ -0,0 +1,234 @@
+#  numpy_backend.py -- Vectorised prime-implicant generation for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""A NumPy implementation of the merge pass of the Quine McCluskey algorithm.
+
+The terms of each round are stored as an (N, 4) array of uint64, one row per
+term with the columns (value, mask, xor_mask, xnor_mask), the same packing as
+used by qm.py. Neighbours of all terms of a group are built with array
+operations and looked up in the adjacent group with a sorted-merge join
+instead of one set probe per term and bit.
+
+This module is used by QuineMcCluskey(backend = "numpy") and requires NumPy.
+It handles functions of up to 64 bits.
+"""
+
+from __future__ import print_function
+import numpy as np
+
+
+MAX_BITS = 64
+
+_VALUE, _MASK, _XOR, _XNOR = 0, 1, 2, 3
+
+_M1 = np.uint64(0x5555555555555555)
+_M2 = np.uint64(0x3333333333333333)
+_M4 = np.uint64(0x0f0f0f0f0f0f0f0f)
+_H01 = np.uint64(0x0101010101010101)
+
+
+
+def _popcount(x):
+    """Return the number of bits set in each element of the uint64 array x."""
+    x = x - ((x >> np.uint64(1)) & _M1)
+    x = (x & _M2) + ((x >> np.uint64(2)) & _M2)
+    x = (x + (x >> np.uint64(4))) & _M4
+    return ((x * _H01) >> np.uint64(56)).astype(np.int64)
+
+
+
+def _lookup(cand_value, cand_sig, value, sig):
+    """Find candidate terms in a group.
+
+    Args:
+        cand_value (array of uint64): the values of the candidate terms.
+        cand_sig (array of uint64): (N, 3) array of the mask, xor_mask and
+        xnor_mask of the candidate terms.
+        value (array of uint64): the values of the terms in the group.
+        sig (array of uint64): (M, 3) array of the masks of the group.
+
+    Returns:
+        A tuple (hit, pos). hit is a boolean array which is True for each
+        candidate which is contained in the group, pos gives the index of the
+        matching term in the group (only meaningful where hit is True).
+
+    Both the signatures and the values are replaced by their dense ranks, so
+    that each term can be represented by a single int64 key. Sorting the keys
+    of the group then allows all candidates to be joined with a single
+    searchsorted call.
+    """
+    n_cand = len(cand_value)
+    _, sig_rank = np.unique(np.concatenate((cand_sig, sig)), axis=0, return_inverse=True)
+    values, value_rank = np.unique(np.concatenate((cand_value, value)), return_inverse=True)
+    sig_rank = sig_rank.reshape(-1).astype(np.int64)
+    value_rank = value_rank.reshape(-1).astype(np.int64)
+    keys = sig_rank * len(values) + value_rank
+    cand_keys = keys[:n_cand]
+    group_keys = keys[n_cand:]
+
+    order = np.argsort(group_keys, kind='mergesort')
+    sorted_keys = group_keys[order]
+    pos = np.searchsorted(sorted_keys, cand_keys)
+    pos = np.minimum(pos, len(sorted_keys) - 1)
+    hit = sorted_keys[pos] == cand_keys
+    return hit, order[pos]
+
+
+
+def _neighbours(group, all_bits, swap):
+    """Build all terms obtained by setting one '0' bit of each term to '1'.
+
+    Args:
+        group (array of uint64): (N, 4) array of packed terms.
+        all_bits (np.uint64): a mask with all n_bits bits set.
+        swap (bool): if True, exchange the xor_mask and the xnor_mask of the
+        neighbours (used to search XOR and XNOR combinations).
+
+    Returns:
+        A tuple (idx, bit, value, sig) of the index of the originating term,
+        the bit which was set, the value and the (N, 3) mask signature of each
+        neighbour.
+    """
+    zeros = all_bits & ~(group[:, _VALUE] | group[:, _MASK] | group[:, _XOR] | group[:, _XNOR])
+    idx_list = []
+    bit_list = []
+    n_bits = int(all_bits).bit_length()
+    for k in range(n_bits):
+        bit = np.uint64(1 << k)
+        idx = np.nonzero(zeros & bit)[0]
+        if len(idx):
+            idx_list.append(idx)
+            bit_list.append(np.full(len(idx), bit, dtype=np.uint64))
+    if not idx_list:
+        return None
+    idx = np.concatenate(idx_list)
+    bit = np.concatenate(bit_list)
+    value = group[idx, _VALUE] | bit
+    if swap:
+        sig = group[idx][:, [_MASK, _XNOR, _XOR]]
+    else:
+        sig = group[idx][:, [_MASK, _XOR, _XNOR]]
+    return idx, bit, value, np.ascontiguousarray(sig)
+
+
+
+def get_prime_implicants(terms, n_bits):
+    """Run the merge rounds of the Quine McCluskey method.
+
+    Args:
+        terms (set of tuple): set of packed terms (value, mask, xor_mask,
+        xnor_mask), including the simple XOR and XNOR terms if required.
+        n_bits (int): the number of bits of the terms.
+
+    Returns:
+        A tuple (pi, n_cmp, n_xor, n_xnor) of the set of packed prime
+        implicants and the number of comparisons performed for the AND, XOR
+        and XNOR combinations.
+
+    The result is identical to the pure-Python implementation in qm.py.
+    """
+    assert n_bits <= MAX_BITS
+    all_bits = np.uint64((1 << n_bits) - 1)
+    n_cmp = n_xor = n_xnor = 0
+
+    current = np.array(sorted(terms), dtype=np.uint64).reshape(-1, 4)
+    marked = []
+    while True:
+        # Group the terms by their number of ones, XORs and XNORs.
+        keys = np.stack((_popcount(current[:, _VALUE]),
+                         _popcount(current[:, _XOR]),
+                         _popcount(current[:, _XNOR])), axis=1)
+        # The algorithm can not cope with mixed XORs and XNORs in one
+        # expression.
+        assert not np.any((keys[:, 1] > 0) & (keys[:, 2] > 0))
+        unique_keys, inverse = np.unique(keys, axis=0, return_inverse=True)
+        inverse = inverse.reshape(-1)
+        groups = dict()
+        for i, key in enumerate(unique_keys):
+            groups[tuple(int(k) for k in key)] = np.nonzero(inverse == i)[0]
+
+        used = np.zeros(len(current), dtype=bool)
+        new_terms = []
+
+        for key, members in groups.items():
+            # Find prime implicants
+            key_next = (key[0] + 1, key[1], key[2])
+            if key_next in groups:
+                n_cmp += _merge(current, members, groups[key_next], all_bits,
+                                False, _MASK, used, True, new_terms)
+            # Find XOR combinations
+            key_complement = (key[0] + 1, key[2], key[1])
+            if key[1] > 0 and key_complement in groups:
+                n_xor += _merge(current, members, groups[key_complement], all_bits,
+                                True, _XOR, used, False, new_terms)
+            # Find XNOR combinations
+            if key[2] > 0 and key_complement in groups:
+                n_xnor += _merge(current, members, groups[key_complement], all_bits,
+                                 True, _XNOR, used, False, new_terms)
+
+        # Add the unused terms to the list of marked terms
+        marked.append(current[~used])
+
+        if not np.any(used):
+            break
+        current = np.unique(np.concatenate(new_terms), axis=0)
+
+    pi = np.concatenate(marked)
+    return set(tuple(int(c) for c in row) for row in pi), n_cmp, n_xor, n_xnor
+
+
+
+def _merge(current, members, partners, all_bits, swap, column, used, mark_partner, new_terms):
+    """Merge the terms of one group with the terms of an adjacent group.
+
+    Args:
+        current (array of uint64): all terms of the current round.
+        members (array of int): index of the terms of the group in current.
+        partners (array of int): index of the terms of the adjacent group.
+        all_bits (np.uint64): a mask with all n_bits bits set.
+        swap (bool): see _neighbours.
+        column (int): the column to which the merged bit is added.
+        used (array of bool): updated with the terms that have been merged.
+        mark_partner (bool): if True, the matching partners are marked as
+        used, too.
+        new_terms (list): the array of merged terms is appended to this list.
+
+    Returns:
+        The number of comparisons performed.
+    """
+    group = current[members]
+    nb = _neighbours(group, all_bits, swap)
+    if nb is None:
+        return 0
+    idx, bit, value, sig = nb
+    partner = current[partners]
+    hit, pos = _lookup(value, sig, partner[:, _VALUE],
+                       np.ascontiguousarray(partner[:, [_MASK, _XOR, _XNOR]]))
+    if np.any(hit):
+        used[members[idx[hit]]] = True
+        if mark_partner:
+            used[partners[pos[hit]]] = True
+        merged = group[idx[hit]].copy()
+        merged[:, column] |= bit[hit]
+        new_terms.append(merged)
+    return len(idx)
@@ -0,0 +1,495 @@
+#  packedcover.py -- A packed cover format for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+
+"""A packed representation of the covers returned by QuineMcCluskey.
+
+A PackedCover holds four integer masks per cube instead of a string: care
+(the bits fixed to '0' or '1'), value (the fixed bits which are '1'), xor
+(the '^' bits) and xnor (the '~' bits). A minterm m is covered by a cube if
+
+    m & care == value
+
+and the number of bits set in m & xor is odd (if xor is not 0) and the
+number of bits set in m & xnor is even (if xnor is not 0).
+
+evaluate works on a NumPy array of minterms with array operations, or on
+any iterable of ints without NumPy. verify checks a cover against the ON-
+and DC-set on truth table chunks of 2**chunk_bits minterms, as bit-slices
+of one Python integer per chunk, without expanding the cubes. Wide functions
+with few care minterms are checked bit-parallel over the sorted care set
+instead: bit j of an integer stands for the j-th care minterm.
+
+The bytes format (see to_bytes) is a 16 byte header followed by the cubes:
+
+    offset  size  contents
+    0       4     the magic bytes b'QMPC'
+    4       1     the format version (1)
+    5       1     reserved, written as zero
+    6       2     n_bits (little endian)
+    8       4     the number of cubes (little endian)
+    12      4     reserved, written as zero
+
+Each cube is stored as its care, value, xor and xnor masks, each one as a
+little endian integer of (n_bits + 7) / 8 bytes.
+
+Example:
+    cover = PackedCover.from_strings(qm.simplify(ones, dc))
+    assert not cover.verify(ones, dc)
+    data = cover.to_bytes()
+"""
+
+from __future__ import print_function
+import struct
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+MAGIC = b'QMPC'
+VERSION = 1
+HEADER = struct.Struct('<4sBxHI4x')
+
+
+
+def _popcount(i):
+    """Return the number of bits set in the non-negative integer i."""
+    return bin(i).count('1')
+
+
+
+def _np_parity(x):
+    """Return the parity of the number of bits set in each element of the
+    uint64 array x."""
+    for shift in (32, 16, 8, 4, 2, 1):
+        x = x ^ (x >> np.uint64(shift))
+    return x & np.uint64(1)
+
+
+
+class PackedCover:
+    """A cover as sequence of packed cubes."""
+    chunk_bits = 12     # log2 of the number of minterms of a verify chunk
+
+
+
+    def __init__(self, n_bits, care = (), value = (), xor = (), xnor = ()):
+        """The class constructor.
+
+        Args:
+            n_bits (int): the number of inputs.
+
+        Kwargs:
+            care, value, xor, xnor (iterable of int): the masks of the cubes,
+            see the module documentation.
+        """
+        self.n_bits = n_bits
+        self.care = tuple(care)
+        self.value = tuple(value)
+        self.xor = tuple(xor)
+        self.xnor = tuple(xnor)
+        if not len(self.care) == len(self.value) == len(self.xor) == len(self.xnor):
+            raise ValueError("the masks of the cubes differ in length")
+
+
+
+    @classmethod
+    def from_strings(cls, terms, n_bits = None):
+        """Build a cover from terms of '0', '1', '-', '^' and '~'.
+
+        Args:
+            terms (iterable of str): the terms, e.g. the result of simplify.
+            Character k of a term stands for bit n_bits - 1 - k.
+
+        Kwargs:
+            n_bits (int): the number of inputs; if None, the length of the
+            terms. It must be given for an empty cover.
+
+        Returns:
+            A PackedCover.
+        """
+        terms = sorted(terms)
+        if n_bits is None:
+            if not terms:
+                raise ValueError("n_bits is required for an empty cover")
+            n_bits = len(terms[0])
+        masks = ([], [], [], [])
+        for t in terms:
+            if len(t) != n_bits:
+                raise ValueError("term %s does not have %d bits" % (t, n_bits))
+            care = value = xor = xnor = 0
+            for c in t:
+                care <<= 1
+                value <<= 1
+                xor <<= 1
+                xnor <<= 1
+                if c == '1':
+                    care |= 1
+                    value |= 1
+                elif c == '0':
+                    care |= 1
+                elif c == '^':
+                    xor |= 1
+                elif c == '~':
+                    xnor |= 1
+                elif c != '-':
+                    raise ValueError("invalid character %r in term %s" % (c, t))
+            for m, x in zip(masks, (care, value, xor, xnor)):
+                m.append(x)
+        return cls(n_bits, *masks)
+
+
+
+    def to_strings(self):
+        """Return the cubes as set of strings, as returned by simplify."""
+        res = set()
+        for care, value, xor, xnor in self:
+            x = []
+            for k in range(self.n_bits - 1, -1, -1):
+                bit = 1 << k
+                if care & bit:
+                    x.append('1' if value & bit else '0')
+                elif xor & bit:
+                    x.append('^')
+                elif xnor & bit:
+                    x.append('~')
+                else:
+                    x.append('-')
+            res.add("".join(x))
+        return res
+
+
+
+    @classmethod
+    def from_bytes(cls, data):
+        """Read a cover written by to_bytes.
+
+        Args:
+            data (bytes-like): the serialised cover.
+
+        Returns:
+            A PackedCover.
+        """
+        data = memoryview(data)
+        if len(data) < HEADER.size:
+            raise ValueError("packed cover too short")
+        magic, version, n_bits, n_cubes = HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError("not a packed cover")
+        width = (n_bits + 7) // 8
+        if len(data) != HEADER.size + 4 * width * n_cubes:
+            raise ValueError("a packed cover of %d cubes must have %d bytes" %
+                    (n_cubes, HEADER.size + 4 * width * n_cubes))
+        masks = ([], [], [], [])
+        pos = HEADER.size
+        for i in range(n_cubes):
+            for m in masks:
+                m.append(int.from_bytes(data[pos:pos + width], 'little'))
+                pos += width
+        return cls(n_bits, *masks)
+
+
+
+    def to_bytes(self):
+        """Serialise the cover, see the module documentation."""
+        width = (self.n_bits + 7) // 8
+        res = [HEADER.pack(MAGIC, VERSION, self.n_bits, len(self))]
+        for cube in self:
+            for m in cube:
+                res.append(m.to_bytes(width, 'little'))
+        return b''.join(res)
+
+
+
+    def __len__(self):
+        return len(self.care)
+
+
+
+    def __iter__(self):
+        """Iterator over the cubes as (care, value, xor, xnor) tuples."""
+        return zip(self.care, self.value, self.xor, self.xnor)
+
+
+
+    def covers(self, m):
+        """Return True if the minterm m is covered by a cube."""
+        for care, value, xor, xnor in self:
+            if m & care == value and \
+                    (not xor or _popcount(m & xor) & 1) and \
+                    (not xnor or not _popcount(m & xnor) & 1):
+                return True
+        return False
+
+
+
+    def evaluate(self, inputs):
+        """Evaluate the cover on many minterms.
+
+        Args:
+            inputs (NumPy array or iterable of int): the minterms.
+
+        Returns:
+            For an array of unsigned integers and a cover of up to 64 bits, a
+            boolean array of the shape of inputs. Otherwise a list of bool.
+        """
+        if np is not None and isinstance(inputs, np.ndarray) and self.n_bits <= 64:
+            x = inputs.astype(np.uint64, copy = False)
+            res = np.zeros(x.shape, dtype = bool)
+            for care, value, xor, xnor in self:
+                hit = (x & np.uint64(care)) == np.uint64(value)
+                if xor:
+                    hit &= _np_parity(x & np.uint64(xor)) == 1
+                if xnor:
+                    hit &= _np_parity(x & np.uint64(xnor)) == 0
+                res |= hit
+            return res
+        return [self.covers(m) for m in inputs]
+
+
+
+    def verify(self, ones, dc = (), max_mismatches = None):
+        """Check the cover against the ON- and the DC-set.
+
+        Args:
+            ones (iterable of int): the minterms for which the output is '1'.
+
+        Kwargs:
+            dc (iterable of int): the don't care minterms; they take
+            precedence over ones.
+
+            max_mismatches (int): stop after this many mismatches, or None.
+
+        Returns:
+            The sorted list of the mismatches: the minterms of the ON-set
+            which are not covered and the covered minterms which are neither
+            in the ON- nor in the DC-set. An empty list if the cover is
+            correct.
+
+        Functions of up to chunk_bits + 4 inputs, and functions whose care
+        minterms times the number of inputs outnumber the minterms of the
+        truth table, are checked over the whole truth table. The other ones
+        are checked over the care minterms only; then at most one covered
+        minterm outside the ON- and DC-set is reported per cube.
+        """
+        dc = set(dc)
+        on = set(ones) - dc
+        k = min(self.n_bits, self.chunk_bits)
+        n_chunks = 1 << (self.n_bits - k)
+        if n_chunks <= 16 or (len(on) + len(dc)) * self.n_bits >= 1 << self.n_bits:
+            res = self.__verify_table(on, dc, k, max_mismatches)
+        else:
+            res = self.__verify_sparse(on, dc, max_mismatches)
+        return res if max_mismatches is None else res[:max_mismatches]
+
+
+
+    def __verify_table(self, on, dc, k, max_mismatches):
+        """verify over the whole truth table, in chunks of 2**k minterms.
+
+        In a chunk, bit j of an integer stands for the minterm whose k lower
+        bits are j. Each cube is a fixed pattern over the lower bits, which
+        depends on the higher bits only through the parities of their XOR
+        and XNOR bits, and it is skipped in the chunks whose higher fixed
+        bits do not match.
+        """
+        size = 1 << k
+        low = size - 1
+        full = (1 << size) - 1
+        planes = []
+        for b in range(k):
+            period = (1 << (1 << b)) - 1
+            plane = 0
+            for start in range(1 << b, size, 2 << b):
+                plane |= period << start
+            planes.append(plane)
+
+        def parity(mask):
+            """The lower bits of the minterms with odd parity in mask."""
+            res = 0
+            for b in range(k):
+                if mask >> b & 1:
+                    res ^= planes[b]
+            return res
+
+        def patterns(care, value, xor, xnor):
+            """The lower bits of the minterms of the cube in a chunk, for
+            each parity of the higher XOR bits (bit 0 of the index) and
+            XNOR bits (bit 1)."""
+            fixed = full
+            for b in range(k):
+                if care >> b & 1:
+                    fixed &= planes[b] if value >> b & 1 else full ^ planes[b]
+            if not xor | xnor:
+                return (fixed,) * 4
+            res = []
+            for i in range(4):
+                r = fixed
+                if xor:
+                    # The XOR bits need an odd parity in total.
+                    p = parity(xor)
+                    r &= full ^ p if i & 1 else p
+                if xnor:
+                    p = parity(xnor)
+                    r &= p if i & 2 else full ^ p
+                res.append(r)
+            return tuple(res)
+
+        # Each cube as (care, value, xor, xnor) of the higher bits and its
+        # patterns.
+        cubes = []
+        for care, value, xor, xnor in self:
+            high = (care & ~low, value & ~low, xor & ~low, xnor & ~low)
+            cubes.append((high, patterns(care, value, xor, xnor)))
+
+        def chunk_sets(terms):
+            """Split terms into the bitsets of the chunks."""
+            offsets = {}
+            for m in terms:
+                offsets.setdefault(m >> k, []).append(m & low)
+            res = {}
+            for c, ms in offsets.items():
+                bits = bytearray((size + 7) // 8)
+                for j in ms:
+                    bits[j >> 3] |= 1 << (j & 7)
+                res[c] = int.from_bytes(bytes(bits), 'little')
+            return res
+
+        on_chunks = chunk_sets(on)
+        dc_chunks = chunk_sets(dc)
+        res = []
+        for c in range(1 << (self.n_bits - k)):
+            base = c << k
+            covered = 0
+            for (care, value, xor, xnor), patterns in cubes:
+                if base & care == value:
+                    covered |= patterns[_popcount(base & xor) & 1 | (_popcount(base & xnor) & 1) << 1]
+            on_bits = on_chunks.get(c, 0)
+            wrong = (on_bits & ~covered) | (covered & ~(on_bits | dc_chunks.get(c, 0)))
+            while wrong:
+                bit = wrong & -wrong
+                res.append(base | bit.bit_length() - 1)
+                wrong ^= bit
+            if max_mismatches is not None and len(res) >= max_mismatches:
+                break
+        return res
+
+
+
+    def __verify_sparse(self, on, dc, max_mismatches):
+        """verify for wide functions with few care minterms.
+
+        The care minterms are sorted, and for each input b an integer has
+        bit j set if b is set in the j-th care minterm. The care minterms
+        covered by a cube are then the AND of these planes (or of their
+        complements) and the parities of the XOR and XNOR planes, which
+        takes O(n_bits) integer operations per cube. A cube is contained in
+        the ON- and the DC-set if it covers as many care minterms as it has
+        minterms; otherwise its minterms are enumerated until one outside is
+        found, and at most popcount + 1 of them are.
+        """
+        care = sorted(on | dc)
+        full = (1 << len(care)) - 1
+        planes = [0] * self.n_bits
+        on_bits = 0
+        for j, m in enumerate(care):
+            bit = 1 << j
+            if m in on:
+                on_bits |= bit
+            b = 0
+            while m:
+                if m & 1:
+                    planes[b] |= bit
+                m >>= 1
+                b += 1
+
+        def parity(mask):
+            """The care minterms with odd parity in mask."""
+            res = 0
+            b = 0
+            while mask:
+                if mask & 1:
+                    res ^= planes[b]
+                mask >>= 1
+                b += 1
+            return res
+
+        res = []
+        covered = 0
+        outside = []
+        for cube in self:
+            c_care, value, xor, xnor = cube
+            bits = full
+            mask = c_care
+            b = 0
+            while mask and bits:
+                if mask & 1:
+                    bits &= planes[b] if value >> b & 1 else full ^ planes[b]
+                mask >>= 1
+                b += 1
+            if xor:
+                bits &= parity(xor)
+            if xnor:
+                bits &= full ^ parity(xnor)
+            covered |= bits
+            n_free = self.n_bits - _popcount(c_care) - (1 if xor else 0) - (1 if xnor else 0)
+            if _popcount(bits) != 1 << n_free:
+                outside.append(cube)
+
+        wrong = on_bits & ~covered
+        while wrong:
+            bit = wrong & -wrong
+            res.append(care[bit.bit_length() - 1])
+            wrong ^= bit
+        care = set(care)
+        for cube in outside:
+            if max_mismatches is not None and len(res) >= max_mismatches:
+                break
+            single = PackedCover(self.n_bits, *([x] for x in cube))
+            for m in single.__minterms():
+                if m not in care:
+                    res.append(m)
+                    break
+        return sorted(set(res))
+
+
+
+    def __minterms(self):
+        """Iterator over the minterms of the first cube."""
+        care, value, xor, xnor = next(iter(self))
+        # The lowest XOR (XNOR) bit is derived from the parity of the others.
+        fix_xor = xor & -xor
+        fix_xnor = xnor & -xnor
+        free = ((1 << self.n_bits) - 1) & ~care & ~fix_xor & ~fix_xnor
+        sub = 0
+        while True:
+            m = value | sub
+            if xor and not _popcount(m & xor) & 1:
+                m |= fix_xor
+            if xnor and _popcount(m & xnor) & 1:
+                m |= fix_xnor
+            yield m
+            sub = (sub - free) & free
+            if sub == 0:
+                break
@@ -0,0 +1,323 @@
+#  parallel.py -- Parallel prime-implicant generation for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""Spread the work of the Quine McCluskey method across processes.
+
+The merges of each pair of adjacent groups (and the XOR/XNOR combinations)
+within one round are independent of each other. At the start of each round
+the terms are packed, grouped and sorted, as four uint64 words per term into
+a multiprocessing.shared_memory segment which the worker processes attach to
+once. The segment is reused by the following rounds and only replaced when it
+has to grow. Each worker merges a slice of one group with its partner group
+and returns the new terms and the indexes of the used terms as packed arrays.
+The results are combined in task order, so the outcome is deterministic and
+identical to the serial implementation.
+
+For batches of functions (QuineMcCluskey.simplify_many and the cofactors of
+QuineMcCluskey.simplify_decomposed) each worker process simplifies whole
+functions with its own QuineMcCluskey instance.
+"""
+
+from __future__ import print_function
+import array
+import multiprocessing
+import time
+try:
+    from multiprocessing import shared_memory
+except ImportError:
+    shared_memory = None    # Python < 3.8: the merge rounds run serially.
+
+
+MAX_BITS = 64       # the terms are packed as uint64 words
+MIN_TERMS = 2048    # rounds with fewer terms are merged serially
+
+_AND, _XOR, _XNOR = 0, 1, 2
+
+# The shared segment attached by a worker process, and the lookup table of
+# the partner group of the current round.
+_shm = None
+_partner_cache = {}
+
+# The QuineMcCluskey instance of a batch worker process.
+_batch_qm = None
+
+
+
+def _attach(name):
+    """Attach the worker process to the shared segment name.
+
+    Returns:
+        The uint64 memoryview of the segment.
+    """
+    global _shm
+    if _shm is None or _shm.name != name:
+        if _shm is not None:
+            _shm.close()
+        _partner_cache.clear()
+        _shm = shared_memory.SharedMemory(name = name)
+    return _shm.buf.cast('Q')
+
+
+
+def _merge_task(task):
+    """Merge a slice of one group with its partner group.
+
+    Args:
+        task (tuple): (name, n_round, kind, n_bits, start, end, partner_start,
+        partner_end). The terms [start, end) of the shared segment name are
+        merged with the terms [partner_start, partner_end). kind selects the
+        AND, XOR or XNOR combination and n_round identifies the contents of
+        the segment.
+
+    Returns:
+        A tuple (terms, used, n_cmp) of the array of the new terms (four
+        words per term), the array of the indexes of the used terms and the
+        number of comparisons.
+    """
+    name, n_round, kind, n_bits, start, end, partner_start, partner_end = task
+    all_bits = (1 << n_bits) - 1
+    s1, s2, s3 = n_bits, 2 * n_bits, 3 * n_bits
+    data = _attach(name)
+    try:
+        # The partners are looked up by the 4 words of a term packed into
+        # one integer.
+        cache_key = (n_round, partner_start, partner_end)
+        partners = _partner_cache.get(cache_key)
+        if partners is None:
+            _partner_cache.clear()
+            w = data[4 * partner_start:4 * partner_end].tolist()
+            keys = [v | m << s1 | x << s2 | xn << s3
+                    for v, m, x, xn in zip(w[0::4], w[1::4], w[2::4], w[3::4])]
+            partners = dict(zip(keys, range(partner_start, partner_end)))
+            _partner_cache[cache_key] = partners
+        w = data[4 * start:4 * end].tolist()
+    finally:
+        data.release()
+
+    terms = array.array('Q')
+    used = array.array('Q')
+    n_cmp = 0
+    for i, value, mask, xor_mask, xnor_mask in zip(range(start, end), w[0::4], w[1::4], w[2::4], w[3::4]):
+        zeros = all_bits & ~(value | mask | xor_mask | xnor_mask)
+        n_cmp += bin(zeros).count('1')
+        if kind == _AND:
+            key = value | mask << s1 | xor_mask << s2 | xnor_mask << s3
+        elif kind == _XOR:
+            # The complement has the '^' replaced by '~'.
+            key = value | mask << s1 | xor_mask << s3
+        else:
+            # The complement has the '~' replaced by '^'.
+            key = value | mask << s1 | xnor_mask << s2
+        while zeros:
+            bit = zeros & -zeros
+            zeros ^= bit
+            k = partners.get(key | bit)
+            if k is None:
+                continue
+            used.append(i)
+            if kind == _AND:
+                used.append(k)
+                terms.extend((value, mask | bit, xor_mask, xnor_mask))
+            elif kind == _XOR:
+                terms.extend((value, mask, xor_mask | bit, 0))
+            else:
+                terms.extend((value, mask, 0, xnor_mask | bit))
+    return terms, used, n_cmp
+
+
+
+class MergePool:
+    """A pool of worker processes for the merge rounds.
+
+    The processes and the shared segment are created on the first call of
+    merge_round and released by close.
+    """
+
+
+
+    def __init__(self, workers, n_bits):
+        """The class constructor.
+
+        Args:
+            workers (int): the number of worker processes.
+            n_bits (int): the number of bits of the terms.
+        """
+        assert n_bits <= MAX_BITS and shared_memory is not None
+        self.workers = workers
+        self.n_bits = n_bits
+        self.pool = None
+        self.shm = None
+        self.n_round = 0
+
+
+
+    def close(self):
+        """Stop the worker processes and remove the shared segment."""
+        if self.pool is not None:
+            self.pool.close()
+            self.pool.join()
+            self.pool = None
+        if self.shm is not None:
+            self.shm.close()
+            self.shm.unlink()
+            self.shm = None
+
+
+
+    def merge_round(self, groups):
+        """Perform one merge round.
+
+        Args:
+            groups (dict): maps each (n_ones, n_xor, n_xnor) key to the set of
+            packed terms with this number of ones, XORs and XNORs.
+
+        Returns:
+            A tuple (terms, used, n_cmp, n_xor, n_xnor) of the set of newly
+            created terms, the set of used terms and the number of AND, XOR
+            and XNOR comparisons.
+        """
+        # Pack the terms, sorted by group, and remember the range of each
+        # group.
+        order = []
+        ranges = {}
+        for key in sorted(groups):
+            start = len(order)
+            order.extend(sorted(groups[key]))
+            ranges[key] = (start, len(order))
+        packed = array.array('Q')
+        for t in order:
+            packed.extend(t)
+        n_bytes = len(packed) * packed.itemsize
+        if self.shm is None or self.shm.size < n_bytes:
+            # Grow the segment geometrically, so that it is rarely replaced.
+            size = max(n_bytes, 2 * self.shm.size if self.shm is not None else 0, 4096)
+            if self.shm is not None:
+                self.shm.close()
+                self.shm.unlink()
+            self.shm = shared_memory.SharedMemory(create = True, size = size)
+        self.shm.buf[:n_bytes] = packed.tobytes()
+        self.n_round += 1
+        if self.pool is None:
+            # The pool is started after the first segment, so that the
+            # workers share the resource tracker of this process and do not
+            # report the segments as leaked when they exit.
+            self.pool = multiprocessing.Pool(self.workers)
+
+        # Split each group into slices so that the workers get similar loads.
+        chunk = max(1, len(order) // (4 * self.workers))
+        tasks = []
+        for key in sorted(groups):
+            start, end = ranges[key]
+            partners = [((key[0] + 1, key[1], key[2]), _AND)]
+            if key[1] > 0:
+                partners.append(((key[0] + 1, key[2], key[1]), _XOR))
+            if key[2] > 0:
+                partners.append(((key[0] + 1, key[2], key[1]), _XNOR))
+            for key_partner, kind in partners:
+                if key_partner in ranges:
+                    p_start, p_end = ranges[key_partner]
+                    for s in range(start, end, chunk):
+                        tasks.append((self.shm.name, self.n_round, kind, self.n_bits,
+                                      s, min(s + chunk, end), p_start, p_end))
+
+        terms = set()
+        used_idx = set()
+        profile = [0, 0, 0]
+        for task, (new_terms, used, n_cmp) in zip(tasks, self.pool.map(_merge_task, tasks)):
+            it = iter(new_terms)
+            terms.update(zip(it, it, it, it))
+            used_idx.update(used)
+            profile[task[2]] += n_cmp
+        used = set(order[i] for i in used_idx)
+        return terms, used, profile[_AND], profile[_XOR], profile[_XNOR]
+
+
+
+def _init_batch(config, attrs):
+    """Create the QuineMcCluskey instance of a batch worker process.
+
+    Args:
+        config (dict): the keyword arguments of the constructor.
+        attrs (dict): the attributes to set on the instance.
+    """
+    global _batch_qm
+    from .qm import QuineMcCluskey
+    _batch_qm = QuineMcCluskey(**config)
+    for name, value in attrs.items():
+        setattr(_batch_qm, name, value)
+
+
+
+def _simplify_task(task):
+    """Simplify one function of a batch.
+
+    Args:
+        task (tuple): (ones, dc, num_bits, end, verify): ones, dc, num_bits
+        and verify as passed to simplify, and the time.time() at which the
+        whole batch has to be done, or None.
+
+    Returns:
+        A tuple (result, profile, status, stats) of the result of simplify,
+        the tuple of the profile counters, the status and the stats.Stats of
+        the call.
+    """
+    ones, dc, num_bits, end, verify = task
+    deadline = None if end is None else max(0.0, end - time.time())
+    res = _batch_qm.simplify(ones, dc, num_bits, deadline = deadline, verify = verify)
+    if res is None:
+        return res, (0, 0, 0), 'complete', None
+    return (res, (_batch_qm.profile_cmp, _batch_qm.profile_xor, _batch_qm.profile_xnor),
+            _batch_qm.status, _batch_qm.stats)
+
+
+
+def simplify_batch(config, attrs, functions, num_bits, workers, end = None, verify = False):
+    """Simplify a batch of functions on a pool of worker processes.
+
+    Args:
+        config (dict): the keyword arguments for the QuineMcCluskey instance
+        of each worker.
+        attrs (dict): the attributes to set on the instance of each worker,
+        e.g. max_mismatches.
+        functions (list of tuple): the (ones, dc) pairs of the functions.
+        num_bits (int): the number of bits of all functions.
+        workers (int): the number of worker processes.
+
+    Kwargs:
+        end (float): the time.time() by which all functions have to be
+        done, or None for no limit.
+
+        verify (bool): see QuineMcCluskey.simplify.
+
+    Returns:
+        A list of (result, profile, status, stats) tuples (see
+        _simplify_task), in the order of the input.
+    """
+    tasks = [(ones, dc, num_bits, end, verify) for ones, dc in functions]
+    chunksize = max(1, len(tasks) // (4 * workers))
+    pool = multiprocessing.Pool(workers, _init_batch, (config, attrs))
+    try:
+        return pool.map(_simplify_task, tasks, chunksize)
+    finally:
+        pool.close()
+        pool.join()
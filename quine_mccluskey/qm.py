@@ -39,163 +39,1901 @@ terms of complexity of the output.
 """
 
 from __future__ import print_function
-import math
 import itertools
 import re
+import threading
+import time
+
+try:
+    from . import _qm
+except ImportError:
+    _qm = None
+from . import aio
+from . import cover
+from . import cubeindex
+from . import heuristic
+from . import packedcover
+from . import parallel
+from . import stats
+from . import truthtable
+from . import zdd
+try:
+    from . import numpy_backend
+except ImportError:
+    numpy_backend = None
+
+
+def _popcount(i):
+    """Return the number of bits set in the non-negative integer i."""
+    return bin(i).count('1')
+
+
+# The positions of the bits set in each byte value, for decoding truth tables.
+_BYTE_BITS = tuple(tuple(k for k in range(8) if b >> k & 1) for b in range(256))
+
+
+
+class _CallContext:
+    """The state of the calls of one thread on a QuineMcCluskey instance."""
+
+
+
+    def __init__(self):
+        """The class constructor."""
+        self.n_bits = 0
+        self.profile_cmp = 0
+        self.profile_xor = 0
+        self.profile_xnor = 0
+        self.status = None
+        self.stats = stats.Stats()
+        self.deadline = None    # The time at which the current call gives up.
+        self.max_primes = None  # The maximum number of prime implicants.
+        self.progress = None    # Called with the stats.Progress of the call.
+        self.cancel_event = threading.Event()
+        self.table = None       # The (n_bits, memoryview) of a mapped truth table.
+
 
 
 class QuineMcCluskey:
     """The Quine McCluskey class.
 
-    The QuineMcCluskey class minimises boolean functions using the Quine
-    McCluskey algorithm.
+    The QuineMcCluskey class minimises boolean functions using the Quine
+    McCluskey algorithm.
+
+    If the class was instantiiated with the use_xor set to True, then the
+    resulting boolean function may contain XOR and XNOR operators.
+
+    One instance can be used by several threads at the same time. The state
+    of a call (n_bits, the profile_* counters, status and stats) is kept per
+    thread, so each thread reads the results of its own last call. An
+    incremental session belongs to the instance and must not be shared.
+    """
+    __version__ = "0.3"
+
+
+
+    backends = ("python", "numpy", "c", "zdd")
+    methods = ("qm", "heuristic")
+    split_terms = 1 << 12   # target cofactor size of simplify_decomposed
+    max_split_bits = 10     # maximum number of split bits
+    max_mismatches = 16     # the mismatches reported by verify
+
+
+
+    def __init__(self, use_xor = False, backend = None, cover_budget = 1.0, workers = 1,
+                 cache = None, method = "qm", hooks = None, prune_dc = False,
+                 reduce_support = False):
+        """The class constructor.
+
+        Kwargs:
+            use_xor (bool): if True, try to use XOR and XNOR operations to give
+            a more compact return.
+
+            backend (str): the implementation of the prime implicant merge
+            pass. "python" is the pure-Python reference implementation.
+            "numpy" handles each group as packed uint64 arrays and is
+            considerably faster for inputs of more than about 12 bits. "c"
+            uses the compiled extension module. The default is "c" if the
+            extension module is available and workers is 1, and "python"
+            otherwise. The numpy and c backends fall back to "python" for
+            inputs wider than 64 bits. "zdd" computes the prime implicants
+            implicitly with decision diagrams (see quine_mccluskey.zdd),
+            which suits dense functions with very many merged terms; it
+            falls back to "python" with use_xor and for simplify_multi.
+
+            cover_budget (float): the maximum time in seconds spent searching
+            for a minimum cover of the prime implicants, or None for no
+            limit. If the time runs out, the best cover found so far is used.
+
+            workers (int): the number of processes used by the "python"
+            backend for the merge rounds of large inputs.
+
+            cache (ResultCache): an optional cache for the results (see
+            quine_mccluskey.cache).
+
+            method (str): "qm" generates all prime implicants with the Quine
+            McCluskey method. "heuristic" improves a cover with Espresso-style
+            EXPAND, IRREDUNDANT and REDUCE passes instead (see
+            quine_mccluskey.heuristic), which scales to many more inputs but
+            does not guarantee a minimum result. With use_xor, XOR and XNOR
+            terms are then only formed from pairs of cubes of the heuristic
+            cover. Incremental sessions always use "qm".
+
+            hooks (list of callable): called with the Stats object (see
+            quine_mccluskey.stats) at the end of each call, e.g. to export
+            the statistics to a metrics system.
+
+            prune_dc (bool): if True, the "python" backend only generates the
+            implicants which cover at least one minterm of the ON-set; the
+            don't care implicants they merge with are checked on demand (see
+            __get_on_prime_implicants). The run time then depends on the
+            ON-set and its neighbourhood rather than on the whole DC-set.
+            The result is the same, but the profile_* counters differ from
+            those of the other backends. It is ignored with workers > 1.
+
+            reduce_support (bool): if True, the inputs the function does not
+            depend on are removed before the minimisation and put back as
+            '-' in the result (see __get_support). The symmetric groups of
+            the remaining inputs are recorded in self.stats.
+        """
+        if backend is None:
+            backend = "c" if _qm is not None and workers <= 1 else "python"
+        if backend not in self.backends:
+            raise ValueError("unknown backend '%s'" % backend)
+        if backend == "numpy" and numpy_backend is None:
+            raise ImportError("the numpy backend requires NumPy")
+        if backend == "c" and _qm is None:
+            raise ImportError("the c backend requires the compiled extension module")
+        if method not in self.methods:
+            raise ValueError("unknown method '%s'" % method)
+        self.use_xor = use_xor  # Whether or not to use XOR and XNOR operations.
+        self.backend = backend  # The implementation of the merge pass.
+        self.cover_budget = cover_budget    # Time limit of the exact cover search.
+        self.workers = workers  # Number of processes for the merge rounds.
+        self.cache = cache      # Optional result cache.
+        self.method = method    # Quine McCluskey or heuristic minimisation.
+        self.hooks = list(hooks or [])  # Called with the stats of each call.
+        self.prune_dc = prune_dc    # Skip the DC-only implicants.
+        self.reduce_support = reduce_support    # Remove the unused inputs.
+        self.__session_ones = None  # The ON-set of the incremental session.
+        self.__local = threading.local()    # The _CallContext of each thread.
+        self.__active = set()   # The contexts of the running calls.
+        self.__lock = threading.Lock()
+
+
+
+    def __context(self):
+        """Return the _CallContext of the current thread."""
+        ctx = getattr(self.__local, 'ctx', None)
+        if ctx is None:
+            ctx = _CallContext()
+            self.__local.ctx = ctx
+        return ctx
+
+
+
+    def __context_attribute(name, doc):
+        """Make a property which accesses an attribute of the _CallContext."""
+        def get(self):
+            return getattr(self.__context(), name)
+        def put(self, value):
+            setattr(self.__context(), name, value)
+        return property(get, put, doc = doc)
+
+    n_bits = __context_attribute('n_bits', "The number of bits of the last call.")
+    profile_cmp = __context_attribute('profile_cmp', "The number of AND comparisons of the last call.")
+    profile_xor = __context_attribute('profile_xor', "The number of XOR comparisons of the last call.")
+    profile_xnor = __context_attribute('profile_xnor', "The number of XNOR comparisons of the last call.")
+    status = __context_attribute('status', "How the last call ended, see simplify.")
+    stats = __context_attribute('stats', "The statistics of the last call, see quine_mccluskey.stats.")
+    del __context_attribute
+
+
+
+    def __term2str(self, term):
+        """
+        Convert a packed term to its string representation.
+
+        Args:
+            term (tuple of int): the term as a (value, mask, xor_mask,
+            xnor_mask) tuple. A bit set in mask, xor_mask or xnor_mask marks
+            a '-', '^' or '~' at this position, otherwise the bit in value
+            gives a '1' or a '0'.
+
+        Returns:
+            The string representation of the term.
+        """
+        value, mask, xor_mask, xnor_mask = term
+        x = []
+        for k in range(self.n_bits - 1, -1, -1):
+            bit = 1 << k
+            if mask & bit:
+                x.append('-')
+            elif xor_mask & bit:
+                x.append('^')
+            elif xnor_mask & bit:
+                x.append('~')
+            elif value & bit:
+                x.append('1')
+            else:
+                x.append('0')
+        return "".join(x)
+
+
+
+    def __str2term(self, s):
+        """
+        Convert the string representation of a term to a packed term.
+
+        Args:
+            s (str): the term as string of '0', '1', '-', '^' and '~'.
+
+        Returns:
+            The term as a (value, mask, xor_mask, xnor_mask) tuple.
+        """
+        value = mask = xor_mask = xnor_mask = 0
+        for c in s:
+            value <<= 1
+            mask <<= 1
+            xor_mask <<= 1
+            xnor_mask <<= 1
+            if c == '1':
+                value |= 1
+            elif c == '-':
+                mask |= 1
+            elif c == '^':
+                xor_mask |= 1
+            elif c == '~':
+                xnor_mask |= 1
+        return (value, mask, xor_mask, xnor_mask)
+
+
+
+    def simplify(self, ones, dc = [], num_bits = None, deadline = None, max_primes = None,
+                 progress = None, verify = False):
+        """Simplify a list of terms.
+
+        Args:
+            ones (iterable of int or bytes): the integers that describe when
+            the output function is '1', e.g. [1, 2, 6, 8, 15]. Any iterable
+            is accepted and consumed in one pass. Alternatively a truth
+            table (see below).
+
+        Kwargs:
+            dc (iterable of int or bytes): the numbers for which we don't care
+            if they have one or zero in the output, in the same formats as
+            ones.
+
+            num_bits (int): the number of bits. If None, it is calculated from
+            the size of the truth table or from the largest term. Only the
+            lower num_bits bits of the terms are used.
+
+            deadline (float): the maximum time in seconds of this call, or
+            None for no limit.
+
+            max_primes (int): stop generating prime implicants when there are
+            more than this many implicants, or None for no limit.
+
+            progress (callable): called with a stats.Progress tuple at the
+            start of the call, after each merge round and during the cover
+            search. If it returns True, the call is cancelled.
+
+            verify (bool): check the result against ones and dc, see below.
+
+        Returns:
+            see: simplify_los.
+
+        When the deadline or max_primes is reached, or if cancel is called
+        from another thread, the remaining steps are cut short: the merge
+        rounds stop and the implicants found so far are used as primes, the
+        exact cover search falls back to the greedy cover, and the final
+        reduction stops. The result is still a valid cover of the function.
+        How the call ended is stored in self.status:
+            'complete': all steps ran to completion.
+            'cover_budget': the cover search was stopped by cover_budget.
+            'deadline', 'max_primes', 'cancelled': the call was cut short.
+            'cached': the result was taken from the cache.
+
+        With verify = True, the result is evaluated over the truth table of
+        the function, 64 minterms per machine word in chunks of 4096
+        minterms (see packedcover.PackedCover.verify). self.stats.mismatches
+        is then the list of the first max_mismatches minterms which are in
+        the ON-set and not covered, or covered and neither in the ON- nor in
+        the DC-set; it is empty if the result is correct.
+
+        A truth table is a bytes, bytearray or memoryview object of
+        max(1, 2**num_bits / 8) bytes. Bit k % 8 of byte k / 8 (counting from
+        the least significant bit) is set if the term k is in the set. The
+        terms are decoded directly from the bitmap, without building an
+        intermediate list.
+
+        Example:
+            ones = [2, 6, 10, 14]
+            dc = []
+
+            This will produce the ouput: ['--10']
+            This means x = b1 & ~b0, (bit1 AND NOT bit0)
+
+        Example:
+            ones = [1, 2, 5, 6, 9, 10, 13, 14]
+            dc = []
+
+            This will produce the ouput: ['--^^'].
+            In other words, x = b1 ^ b0, (bit1 XOR bit0).
+
+        Example:
+            ones = bytes([0x66, 0x66])
+
+            This is the truth table of the previous example and produces the
+            same output.
+        """
+        ones, ones_bits = self.__read_terms(ones, num_bits)
+        dc, dc_bits = self.__read_terms(dc, num_bits)
+        if len(ones) == 0 and len(dc) == 0:
+            return None
+
+        # Calculate the number of bits to use
+        if num_bits is not None:
+            self.n_bits = num_bits
+        elif ones_bits is not None or dc_bits is not None:
+            if ones_bits is not None and dc_bits is not None and ones_bits != dc_bits:
+                raise ValueError("the truth tables of ones and dc differ in size")
+            self.n_bits = ones_bits if ones_bits is not None else dc_bits
+        else:
+            self.n_bits = max(max(ones) if ones else 0, max(dc) if dc else 0).bit_length()
+
+        return self.__simplify_budget(ones, dc, deadline, max_primes, progress, verify)
+
+
+
+    def simplify_task(self, ones, dc = [], num_bits = None, deadline = None, max_primes = None,
+                      executor = None):
+        """Start simplify in an executor of the running asyncio event loop.
+
+        Args:
+            ones (iterable of int or bytes): see simplify.
+
+        Kwargs:
+            dc, num_bits, deadline, max_primes: see simplify.
+
+            executor (concurrent.futures.Executor): the executor, or None for
+            the default executor of the loop.
+
+        Returns:
+            An aio.SimplifyTask, which is an async iterator of the progress of
+            the call and can be awaited for its result.
+
+        Example:
+            task = qm.simplify_task(ones, dc)
+            async for p in task:
+                print(p.round, p.n_primes)
+            res = await task
+        """
+        return aio.SimplifyTask(self, ones, dc, num_bits, deadline, max_primes, executor)
+
+
+
+    async def simplify_async(self, ones, dc = [], num_bits = None, deadline = None, max_primes = None,
+                             executor = None):
+        """Simplify a list of terms without blocking the asyncio event loop.
+
+        Args:
+            ones (iterable of int or bytes): see simplify.
+
+        Kwargs:
+            dc, num_bits, deadline, max_primes, executor: see simplify_task.
+
+        Returns:
+            see: simplify_los.
+
+        If the awaiting task is cancelled, the call is cancelled as well and
+        asyncio.CancelledError is raised. n_bits, the profile_* counters,
+        status and stats are those of the call when it returns, until the
+        next call of the thread of the event loop.
+        """
+        task = self.simplify_task(ones, dc, num_bits, deadline, max_primes, executor)
+        res = await task
+        self.n_bits = task.n_bits
+        self.status = task.status
+        self.stats = task.stats
+        self.profile_cmp = task.stats.profile_cmp
+        self.profile_xor = task.stats.profile_xor
+        self.profile_xnor = task.stats.profile_xnor
+        return res
+
+
+
+    def cancel(self):
+        """Cancel the running calls of simplify from another thread.
+
+        The calls of all threads on this instance return at their next check
+        with the best valid cover found so far and status set to
+        'cancelled'.
+        """
+        with self.__lock:
+            for ctx in self.__active:
+                ctx.cancel_event.set()
+
+
+
+    def __begin_call(self, deadline = None, max_primes = None, progress = None):
+        """Prepare the context of the current thread for a new call.
+
+        Kwargs:
+            deadline (float): see simplify.
+            max_primes (int): see simplify.
+            progress (callable): see simplify.
+
+        Returns:
+            The _CallContext of the call, to be passed to __end_call.
+        """
+        ctx = self.__context()
+        ctx.cancel_event.clear()
+        ctx.deadline = None if deadline is None else time.time() + deadline
+        ctx.max_primes = max_primes
+        ctx.stats = stats.Stats()
+        ctx.progress = progress
+        with self.__lock:
+            self.__active.add(ctx)
+        self.__report('start')
+        return ctx
+
+
+
+    def __end_call(self, ctx):
+        """Release the context of a call started by __begin_call."""
+        ctx.deadline = None
+        ctx.max_primes = None
+        ctx.progress = None
+        ctx.table = None
+        with self.__lock:
+            self.__active.discard(ctx)
+
+
+
+    def __simplify_budget(self, ones, dc, deadline, max_primes, progress = None, verify = False,
+                          table = None):
+        """Run __simplify_cached with a deadline, a limit of primes and a
+        progress callable, and verify the result if asked to.
+
+        table is the truthtable.MappedTable ones and dc were read from, if
+        any; the c backend then reads the minterms from the mapped table.
+        """
+        ctx = self.__begin_call(deadline, max_primes, progress)
+        if table is not None:
+            ctx.table = (table.n_bits, table.table)
+        try:
+            res = self.__simplify_cached(ones, dc)
+            if verify and res is not None:
+                self.__verify_result(ones, dc, res)
+        finally:
+            self.__end_call(ctx)
+        return self.__finish_stats(res)
+
+
+
+    def __verify_result(self, ones, dc, res):
+        """Record the mismatches of res against ones and dc in self.stats."""
+        with self.stats.phase('verify'):
+            cover = packedcover.PackedCover.from_strings(res, self.n_bits)
+            self.stats.mismatches = cover.verify(ones, dc, self.max_mismatches)
+
+
+
+    def __finish_stats(self, res):
+        """Complete the statistics of the current call and run the hooks.
+
+        Args:
+            res (set of str): the result of the call, or None.
+
+        Returns:
+            res.
+        """
+        st = self.stats
+        st.wall_time = time.time() - st.start
+        st.profile_cmp = self.profile_cmp
+        st.profile_xor = self.profile_xor
+        st.profile_xnor = self.profile_xnor
+        st.status = self.status
+        if res is not None:
+            st.n_terms = len(res) if isinstance(res, set) else len(set().union(*res))
+        for hook in self.hooks:
+            hook(st)
+        return res
+
+
+
+    def __report(self, phase, n_nodes = 0):
+        """Pass the progress of the current call to its progress callable.
+
+        Args:
+            phase (str): the phase of the call, see stats.Progress.
+
+        Kwargs:
+            n_nodes (int): the number of nodes of the cover search so far.
+
+        The call is cancelled if the callable returns True.
+        """
+        ctx = self.__context()
+        if ctx.progress is None:
+            return
+        st = ctx.stats
+        event = stats.Progress(phase, len(st.primes_per_round),
+                               st.n_primes or sum(st.primes_per_round), n_nodes)
+        if ctx.progress(event):
+            ctx.cancel_event.set()
+
+
+
+    def __native_checkpoint(self, n_round, n_primes, n_terms):
+        """The stop callable of the merge rounds of the c backend.
+
+        Args:
+            n_round (int): the number of merge rounds done so far.
+            n_primes (int): the number of prime implicants so far.
+            n_terms (int): the number of all implicants so far.
+
+        Returns:
+            True if the merge rounds have to stop, see __out_of_budget.
+
+        The progress callable receives a 'primes' event, so that it can
+        cancel the call while the c backend merges.
+        """
+        ctx = self.__context()
+        if ctx.progress is not None and ctx.progress(stats.Progress('primes', n_round, n_primes, 0)):
+            ctx.cancel_event.set()
+        return self.__out_of_budget(n_terms)
+
+
+
+    def __out_of_budget(self, n_terms = None):
+        """Check whether the current call has to be cut short.
+
+        Args:
+            n_terms (int): the number of implicants so far, compared with
+            max_primes, or None.
+
+        Returns:
+            True if the call was cancelled or the deadline or max_primes was
+            reached. self.status is updated with the reason.
+        """
+        ctx = self.__context()
+        if ctx.cancel_event.is_set():
+            reason = 'cancelled'
+        elif ctx.deadline is not None and time.time() > ctx.deadline:
+            reason = 'deadline'
+        elif n_terms is not None and ctx.max_primes is not None and n_terms > ctx.max_primes:
+            reason = 'max_primes'
+        else:
+            return False
+        if ctx.status in ('complete', 'cover_budget'):
+            ctx.status = reason
+        return True
+
+
+
+    def __read_terms(self, terms, num_bits):
+        """Read the terms of an iterable or a truth table into a set.
+
+        Args:
+            terms (iterable of int or bytes): the terms in one of the formats
+            accepted by simplify.
+            num_bits (int): the number of bits, or None.
+
+        Returns:
+            A tuple (terms, n_bits) of the set of integer terms and the number
+            of bits implied by the size of the truth table, or None if terms
+            is not a truth table.
+        """
+        if not isinstance(terms, (bytes, bytearray, memoryview)):
+            terms = set(terms)
+            if num_bits is not None and terms and max(terms) >> num_bits:
+                # Only the lower num_bits bits of a term are used.
+                all_bits = (1 << num_bits) - 1
+                terms = set(t & all_bits for t in terms)
+            return terms, None
+
+        table = memoryview(terms).cast('B')
+        n_terms = 8 * len(table)
+        if num_bits is None:
+            num_bits = n_terms.bit_length() - 1
+            if n_terms != 1 << num_bits:
+                raise ValueError("the size of the truth table is not a power of two")
+        elif len(table) != max(1, (1 << num_bits) // 8):
+            raise ValueError("the truth table must have %d bytes" % max(1, (1 << num_bits) // 8))
+        n_terms = min(n_terms, 1 << num_bits)
+
+        res = set()
+        for i, byte in enumerate(table):
+            if byte:
+                base = 8 * i
+                res.update(base + k for k in _BYTE_BITS[byte])
+        if n_terms < 8:
+            res = set(t for t in res if t < n_terms)
+        return res, num_bits
+
+
+
+    def simplify_many(self, functions, num_bits = None, verify = False):
+        """Simplify a batch of functions.
+
+        Args:
+            functions (list of tuple): list of (ones, dc) pairs, one for each
+            function, in the formats accepted by simplify. The dc element may
+            be omitted.
+
+        Kwargs:
+            num_bits (int): the number of bits of all functions. If None, it
+            is calculated once from the largest term of the whole batch, so
+            all results have the same width.
+
+            verify (bool): see simplify.
+
+        Returns:
+            A list with the result of simplify for each function, in the
+            order of the input. The profile_* counters hold the totals of
+            the whole batch.
+
+        If the instance was created with workers > 1, the functions are
+        distributed across a pool of worker processes. Each worker keeps one
+        configured QuineMcCluskey instance for the whole batch. The cache
+        and the hooks of the instance are used as by a call of simplify per
+        function: the functions found in the cache are not sent to the
+        workers, the complete results of the workers are stored, and the
+        hooks are called with the stats of each function in input order.
+
+        Example:
+            qm.simplify_many([([1, 3], [2]), ([0, 2],)])
+
+            This will produce the output: [set(['-1']), set(['-0'])].
+        """
+        functions = [(self.__read_terms(f[0], num_bits), self.__read_terms(f[1] if len(f) > 1 else [], num_bits))
+                     for f in functions]
+        if num_bits is None:
+            num_bits = 0
+            for (ones, ones_bits), (dc, dc_bits) in functions:
+                for terms, n_bits in ((ones, ones_bits), (dc, dc_bits)):
+                    if n_bits is None:
+                        n_bits = max(terms).bit_length() if terms else 0
+                    num_bits = max(num_bits, n_bits)
+        functions = [(ones, dc) for (ones, _), (dc, _) in functions]
+
+        results = self.__simplify_batch(functions, num_bits, verify = verify)
+        self.n_bits = num_bits
+        self.profile_cmp = sum(p[0] for _, p, _ in results)
+        self.profile_xor = sum(p[1] for _, p, _ in results)
+        self.profile_xnor = sum(p[2] for _, p, _ in results)
+        return [res for res, _, _ in results]
+
+
+
+    def __simplify_batch(self, functions, num_bits, end = None, verify = False):
+        """Simplify the functions of a batch, on the worker pool if workers > 1.
+
+        Args:
+            functions (list of tuple): the (ones, dc) pairs of sets of int.
+            num_bits (int): the number of bits of all functions.
+
+        Kwargs:
+            end (float): the time.time() by which the whole batch has to be
+            done, or None for no limit.
+
+            verify (bool): see simplify.
+
+        Returns:
+            A list of (result, profile, status) tuples, one for each
+            function, with the result, the profile_* counters and the status
+            of its call.
+        """
+        if self.workers <= 1 or len(functions) <= 1:
+            results = []
+            for ones, dc in functions:
+                deadline = None if end is None else max(0.0, end - time.time())
+                res = self.simplify(ones, dc, num_bits, deadline = deadline, verify = verify)
+                results.append(self.__batch_result(res))
+            return results
+
+        # Look up the functions in the cache first. A function with the
+        # entry of an earlier miss is simplified after the pool, when the
+        # result of the earlier one may be in the cache.
+        entries = [None] * len(functions)
+        hits = {}
+        tasks = []
+        deferred = set()
+        missed = set()
+        options = self.__cache_options()
+        for i, (ones, dc) in enumerate(functions):
+            if not ones and not dc:
+                continue
+            if self.cache is None:
+                tasks.append(i)
+                continue
+            entry = self.cache.entry(ones, dc, num_bits, self.use_xor, options)
+            if entry[0] in missed:
+                deferred.add(i)
+                continue
+            res = self.cache.lookup(entry)
+            if res is not None:
+                hits[i] = res
+            else:
+                missed.add(entry[0])
+                entries[i] = entry
+                tasks.append(i)
+
+        config = dict(use_xor = self.use_xor, backend = self.backend,
+                      cover_budget = self.cover_budget, method = self.method,
+                      prune_dc = self.prune_dc, reduce_support = self.reduce_support)
+        attrs = dict(max_mismatches = self.max_mismatches)
+        pooled = {}
+        if tasks:
+            pool_results = parallel.simplify_batch(config, attrs, [functions[i] for i in tasks], num_bits,
+                                                   self.workers, end, verify)
+            pooled = dict(zip(tasks, pool_results))
+
+        # Replay the calls in input order, as a call of simplify would have
+        # completed them.
+        results = []
+        for i, (ones, dc) in enumerate(functions):
+            if i in hits:
+                res = self.__replay_call(ones, dc, num_bits, hits[i], (0, 0, 0), 'cached', None, verify)
+            elif i in pooled:
+                res, profile, status, st = pooled[i]
+                res = self.__replay_call(ones, dc, num_bits, res, profile, status, st, False)
+                if entries[i] is not None and res is not None and status == 'complete':
+                    self.cache.store(entries[i], res)
+            elif i in deferred:
+                deadline = None if end is None else max(0.0, end - time.time())
+                res = self.simplify(ones, dc, num_bits, deadline = deadline, verify = verify)
+            else:
+                res = None
+            results.append(self.__batch_result(res))
+        return results
+
+
+
+    def __batch_result(self, res):
+        """The (result, profile, status) tuple of the last call."""
+        if res is None:
+            return res, (0, 0, 0), 'complete'
+        return res, (self.profile_cmp, self.profile_xor, self.profile_xnor), self.status
+
+
+
+    def __replay_call(self, ones, dc, num_bits, res, profile, status, st, verify):
+        """Complete a call of simplify whose result was found elsewhere.
+
+        Args:
+            ones (set of int): the minterms of the ON-set.
+            dc (set of int): the don't care minterms.
+            num_bits (int): the number of bits.
+            res (set of str): the result.
+            profile (tuple): the profile_* counters of the call.
+            status (str): the status of the call.
+            st (stats.Stats): the statistics of the call, or None for new
+            ones.
+            verify (bool): see simplify.
+
+        Returns:
+            res, after the state of the current thread has been set as by
+            simplify and the hooks have been called.
+        """
+        self.n_bits = num_bits
+        ctx = self.__begin_call()
+        try:
+            if st is not None:
+                # Keep the wall time of the call in the worker process.
+                st.start = time.time() - st.wall_time
+                ctx.stats = st
+            self.profile_cmp, self.profile_xor, self.profile_xnor = profile
+            self.status = status
+            if verify and res is not None:
+                self.__verify_result(ones, dc, res)
+        finally:
+            self.__end_call(ctx)
+        return self.__finish_stats(res)
+
+
+
+    def simplify_decomposed(self, ones, dc = [], num_bits = None, split_bits = None, deadline = None):
+        """Simplify a wide function by Shannon decomposition.
+
+        Args:
+            ones (iterable of int or bytes): see simplify.
+
+        Kwargs:
+            dc (iterable of int or bytes): see simplify.
+
+            num_bits (int): see simplify.
+
+            split_bits (list of int): the bit positions to split on, or None
+            to choose them (see __get_split_bits).
+
+            deadline (float): the maximum time in seconds of the whole call,
+            or None for no limit.
+
+        Returns:
+            see: simplify_los.
+
+        The function is split into the cofactors of all values of the split
+        bits, which are minimised independently with simplify, on the worker
+        pool if the instance has workers > 1. Each cube of the partial
+        covers is then expanded over the split bits as long as it stays an
+        implicant, and the orthogonal merge and the redundancy removal of
+        the final reduction of simplify run over the union of the cubes. The
+        result is a valid cover, but not necessarily a minimum one. The
+        profile_* counters hold the totals of the cofactors; self.status is
+        the first status of a cofactor or of the merge which is not
+        'complete'.
+        """
+        end = None if deadline is None else time.time() + deadline
+        ones, ones_bits = self.__read_terms(ones, num_bits)
+        dc, dc_bits = self.__read_terms(dc, num_bits)
+        if len(ones) == 0 and len(dc) == 0:
+            return None
+        if num_bits is None:
+            num_bits = ones_bits if ones_bits is not None else dc_bits
+        if num_bits is None:
+            num_bits = max(ones | dc).bit_length()
+        on = ones - dc
+        if split_bits is None:
+            split_bits = self.__get_split_bits(on | dc, num_bits)
+        split_bits = sorted(set(split_bits))
+        rest = [b for b in range(num_bits) if b not in split_bits]
+        split_mask = sum(1 << b for b in split_bits)
+
+        # The cofactors over the remaining bits, by the value of the split
+        # bits. Cofactors without ones need no cubes.
+        cofactors = {}
+        for terms, k in ((on, 0), (dc, 1)):
+            for m in terms:
+                key = m & split_mask
+                if key not in cofactors:
+                    cofactors[key] = (set(), set())
+                cofactors[key][k].add(self.__project(m, rest))
+        keys = sorted(key for key in cofactors if cofactors[key][0])
+        results = self.__simplify_batch([cofactors[key] for key in keys], len(rest), end)
+
+        self.n_bits = num_bits
+        ctx = self.__begin_call(None if end is None else max(0.0, end - time.time()))
+        try:
+            self.profile_cmp = sum(p[0] for _, p, _ in results)
+            self.profile_xor = sum(p[1] for _, p, _ in results)
+            self.profile_xnor = sum(p[2] for _, p, _ in results)
+            self.status = 'complete'
+            for _, _, status in results:
+                if status != 'complete':
+                    self.status = status
+                    break
+            covers = [(key, res) for key, (res, _, _) in zip(keys, results)]
+            res = self.__merge_cofactors(covers, split_bits, rest, on, dc)
+        finally:
+            self.__end_call(ctx)
+        return self.__finish_stats(res)
+
+
+
+    def __get_split_bits(self, care, num_bits):
+        """Choose the split bits of simplify_decomposed.
+
+        Args:
+            care (set of int): the union of the ON- and the DC-set.
+            num_bits (int): the number of bits.
+
+        Returns:
+            The list of the bit positions which divide care most evenly,
+            as many as needed for cofactors of about split_terms minterms,
+            but at most max_split_bits and never all bits.
+        """
+        n_split = 0
+        while len(care) >> n_split > self.split_terms:
+            n_split += 1
+        n_split = min(n_split, self.max_split_bits, max(num_bits - 1, 0))
+        counts = [0] * num_bits
+        for m in care:
+            for b in range(num_bits):
+                counts[b] += m >> b & 1
+        by_balance = sorted(range(num_bits), key = lambda b: (abs(2 * counts[b] - len(care)), b))
+        return sorted(by_balance[:n_split])
+
+
+
+    def __merge_cofactors(self, covers, split_bits, rest, on, dc):
+        """Combine the covers of the cofactors into a cover of the function.
+
+        Args:
+            covers (list of tuple): (key, cover) of each cofactor with ones,
+            the values of the split bits and the result of simplify.
+
+            split_bits (list of int): the split bit positions.
+
+            rest (list of int): the other bit positions, in the order of the
+            bits of the cofactors.
+
+            on (set of int): the ON-set without the don't cares.
+
+            dc (set of int): the don't care minterms.
+
+        Returns:
+            see: simplify_los.
+        """
+        on_index = dict((n, k) for k, n in enumerate(sorted(on)))
+        dc_index = dict((n, k) for k, n in enumerate(sorted(dc)))
+
+        def deposit(x):
+            """Move bit p of a cofactor term to bit rest[p]."""
+            res = 0
+            for p, b in enumerate(rest):
+                res |= (x >> p & 1) << b
+            return res
+
+        def is_implicant(t):
+            """Return True if all minterms of t are in the ON- or DC-set."""
+            n_xor = _popcount(t[2] | t[3])
+            size = 1 << (_popcount(t[1]) + max(n_xor - 1, 0))
+            return _popcount(self.__get_coverage(t, on_index)) + \
+                    _popcount(self.__get_coverage(t, dc_index)) == size
+
+        cubes = set()
+        for key, cover in covers:
+            for s in cover:
+                t = self.__str2term(s)
+                cubes.add((deposit(t[0]) | key, deposit(t[1]), deposit(t[2]), deposit(t[3])))
+
+        # Free each split bit of a cube if the other half is an implicant.
+        expanded = set()
+        with self.stats.phase('merge'):
+            for t in sorted(cubes):
+                for b in split_bits:
+                    if self.__out_of_budget():
+                        break
+                    bit = 1 << b
+                    if is_implicant((t[0] ^ bit, t[1], t[2], t[3])):
+                        t = (t[0] & ~bit, t[1] | bit, t[2], t[3])
+                expanded.add(t)
+        return self.__reduce_implicants(set(self.__term2str(t) for t in expanded), on_index, dc)
+
+
+
+    def simplify_multi(self, outputs, dc = [], num_bits = None):
+        """Simplify a multi-output function with shared product terms.
+
+        Args:
+            outputs (list): the ON-set of each output, in the formats
+            accepted by simplify.
+
+        Kwargs:
+            dc (iterable of int or bytes): the don't care minterms, shared
+            by all outputs.
+
+            num_bits (int): the number of bits. If None, it is calculated
+            from the truth tables or from the largest term of all outputs.
+
+        Returns:
+            A list with one set of strings (see simplify_los) for each
+            output, in the order of the input. An output with an empty
+            ON-set has an empty set. The same string in several sets is one
+            shared product term.
+
+        All outputs are minimised together: the prime implicants are
+        generated in one pass, each tagged with the mask of the outputs it
+        is an implicant of, and one cover is selected which minimises the
+        number of distinct product terms first. Each output then uses an
+        irredundant subset of the selected terms. This always uses the "qm"
+        method and the serial "python" merge rounds; cancel and
+        cover_budget apply as in simplify.
+        """
+        outputs = [self.__read_terms(f, num_bits) for f in outputs]
+        dc, dc_bits = self.__read_terms(dc, num_bits)
+        if num_bits is None:
+            num_bits = 0
+            for terms, n_bits in outputs + [(dc, dc_bits)]:
+                if n_bits is None:
+                    n_bits = max(terms).bit_length() if terms else 0
+                num_bits = max(num_bits, n_bits)
+        self.n_bits = num_bits
+        ctx = self.__begin_call()
+        try:
+            res = self.__simplify_multi_packed([ones for ones, _ in outputs], dc)
+        finally:
+            self.__end_call(ctx)
+        return self.__finish_stats(res)
+
+
+
+    def __simplify_multi_packed(self, outputs, dc):
+        """The multi-output simplification for integer-encoded inputs.
+
+        Args:
+            outputs (list of set of int): the ON-set of each output.
+            dc (set of int): the shared don't care minterms.
+
+        Returns:
+            see: simplify_multi.
+        """
+        self.profile_cmp = 0
+        self.profile_xor = 0
+        self.profile_xnor = 0
+        self.status = 'complete'
+        st = self.stats
+
+        # Tag each minterm with the outputs it is an implicant of.
+        tags = dict()
+        for i, ones in enumerate(outputs):
+            for m in ones:
+                t = (m, 0, 0, 0)
+                tags[t] = tags.get(t, 0) | 1 << i
+        for m in dc:
+            tags[(m, 0, 0, 0)] = (1 << len(outputs)) - 1
+        with st.phase('primes'):
+            prime_implicants = self.__get_prime_implicants(set(tags), tags)
+
+        # The rows of the joint covering problem are the (output, minterm)
+        # pairs of the ON-sets; output i owns the rows from offsets[i] on.
+        on_indexes = []
+        offsets = []
+        n_rows = 0
+        for ones in outputs:
+            on_indexes.append(dict((n, k) for k, n in enumerate(sorted(ones - dc))))
+            offsets.append(n_rows)
+            n_rows += len(on_indexes[-1])
+        local = dict()
+        coverage = dict()
+        with st.phase('coverage'):
+            for t in prime_implicants:
+                cov = 0
+                for i in range(len(outputs)):
+                    if tags[t] >> i & 1:
+                        local[(t, i)] = self.__get_coverage(t, on_indexes[i])
+                        cov |= local[(t, i)] << offsets[i]
+                if cov:
+                    coverage[t] = cov
+            st.n_primes = len(prime_implicants)
+            st.coverage_rows = n_rows
+            st.coverage_columns = len(coverage)
+            st.coverage_entries = sum(_popcount(c) for c in coverage.values())
+
+        selected = set()
+        if n_rows:
+            with st.phase('essential'):
+                initial = self.__get_essential_implicants(coverage)
+            with st.phase('cover'):
+                selected = self.__get_minimum_cover(coverage, initial, n_rows)
+
+        results = []
+        redundancy_start = time.time()
+        for i in range(len(outputs)):
+            # Drop the terms which are redundant for this output, the most
+            # complex first.
+            terms = dict((t, local[(t, i)]) for t in selected if local.get((t, i)))
+            for t in sorted(terms, key=lambda t: (-self.__get_term_cost(t), t)):
+                others = 0
+                for u in terms:
+                    if u != t:
+                        others |= terms[u]
+                if terms[t] & ~others == 0:
+                    del terms[t]
+            results.append(set(self.__term2str(t) for t in terms))
+        st.times['redundancy'] += time.time() - redundancy_start
+        return results
+
+
+
+    def simplify_file(self, path, deadline = None, max_primes = None, verify = False):
+        """Simplify a function stored in a truth table file.
+
+        Args:
+            path (str): the name of a file in the format of
+            quine_mccluskey.truthtable. The number of bits is taken from the
+            header of the file.
+
+        Kwargs:
+            deadline (float): see simplify.
+            max_primes (int): see simplify.
+            verify (bool): see simplify.
+
+        Returns:
+            see: simplify_los.
+
+        The file is memory-mapped and stays mapped during the call. The c
+        backend generates the prime implicants from the mapped table, so no
+        Python objects are created for the minterms in that step; the ON
+        and DC minterms are still decoded into sets of ints for the cover
+        selection and the final reduction. The other backends, and the c
+        backend when the support of the function is reduced, work on the
+        decoded sets.
+        """
+        with truthtable.MappedTable(path) as table:
+            ones, dc = table.decode()
+            if len(ones) == 0 and len(dc) == 0:
+                return None
+            self.n_bits = table.n_bits
+            return self.__simplify_budget(ones, dc, deadline, max_primes, verify = verify,
+                                          table = table)
+
+
+
+    def simplify_cover(self, ones, dc = [], num_bits = None, deadline = None, max_primes = None,
+                       verify = False):
+        """Simplify a list of terms and return the result as packed cover.
+
+        Args:
+            ones (iterable of int or bytes): see simplify.
+
+        Kwargs:
+            dc, num_bits, deadline, max_primes, verify: see simplify.
+
+        Returns:
+            A packedcover.PackedCover of the cubes of the result of simplify,
+            which can be evaluated, verified and serialised without parsing
+            the strings again, or None if ones and dc are empty.
+        """
+        res = self.simplify(ones, dc, num_bits, deadline = deadline, max_primes = max_primes,
+                            verify = verify)
+        if res is None:
+            return None
+        return packedcover.PackedCover.from_strings(res, self.n_bits)
+
+
+
+    def simplify_los(self, ones, dc = [], num_bits = None, deadline = None, max_primes = None,
+                     verify = False):
+        """The simplification algorithm for a list of string-encoded inputs.
+
+        Args:
+            ones (iterable of str): the strings that describe when the output
+            function is '1', e.g. ['0001', '0010', '0110', '1000', '1111'].
+
+        Kwargs:
+            dc: (iterable of str): the strings that define the don't care
+            combinations.
+
+            num_bits (int): the number of bits. Only the last num_bits
+            characters of longer strings are used. Default: the length of
+            the strings.
+
+            deadline (float): see simplify.
+
+            max_primes (int): see simplify.
+
+            verify (bool): see simplify.
+
+        Returns:
+            Returns a set of strings which represent the reduced minterms.  The
+            length of the strings is equal to the number of bits in the input.
+            Character 0 of the output string stands for the most significant
+            bit, Character n - 1 (n is the number of bits) stands for the least
+            significant bit.
+
+            The following characters are allowed in the return string:
+              '-' don't care: this bit can be either zero or one.
+              '1' the bit must be one.
+              '0' the bit must be zero.
+              '^' all bits with the caret are XOR-ed together.
+              '~' all bits with the tilde are XNOR-ed together.
+
+        Example:
+            ones = ['0010', '0110', '1010', '1110']
+            dc = []
+
+            This will produce the ouput: ['--10'].
+            In other words, x = b1 & ~b0, (bit1 AND NOT bit0).
+
+        Example:
+            ones = ['0001', '0010', '0101', '0110', '1001', '1010' '1101', '1110']
+            dc = []
+
+            This will produce the ouput: ['--^^'].
+            In other words, x = b1 ^ b0, (bit1 XOR bit0).
+        """
+        # Strings are only used at the API boundary, internally the
+        # minterms are handled as integers. The lengths are collected while
+        # converting, so the inputs are read only once.
+        lengths = set()
+        ones = self.__read_los(ones, lengths)
+        dc = self.__read_los(dc, lengths)
+        if len(ones) == 0 and len(dc) == 0:
+            return None
+
+        # Calculate the number of bits to use
+        if num_bits is not None:
+            self.n_bits = num_bits
+            if max(lengths) > num_bits:
+                # Only the lower num_bits bits of a term are used.
+                all_bits = (1 << num_bits) - 1
+                ones = set(t & all_bits for t in ones)
+                dc = set(t & all_bits for t in dc)
+        else:
+            self.n_bits = max(lengths)
+            if self.n_bits != min(lengths):
+                return None
+
+        return self.__simplify_budget(ones, dc, deadline, max_primes, verify = verify)
+
+
+
+    def start_session(self, ones, dc = [], num_bits = None):
+        """Simplify a function and keep its state for incremental updates.
+
+        Args:
+            ones (iterable of int or bytes): see simplify.
+
+        Kwargs:
+            dc (iterable of int or bytes): see simplify.
+
+            num_bits (int): see simplify. The number of bits is fixed for the
+            whole session.
+
+        Returns:
+            see: simplify.
+
+        The prime implicants and their coverage of the ON-set are kept after
+        this call. add_ones, remove_ones, add_dc and remove_dc then update
+        the prime implicants around the changed minterms only, and re-solve
+        only the independent parts of the covering problem whose rows or
+        columns have changed.
+
+        Without XOR, the prime implicants are the maximal cubes of the ON-
+        and DC-set, which can be updated locally. With use_xor the prime
+        implicants are recalculated after each change, but the cover is
+        still updated incrementally.
+
+        A term which is added to the ON-set is removed from the DC-set and
+        vice versa.
+        """
+        ones, ones_bits = self.__read_terms(ones, num_bits)
+        dc, dc_bits = self.__read_terms(dc, num_bits)
+        if num_bits is not None:
+            self.n_bits = num_bits
+        elif ones_bits is not None or dc_bits is not None:
+            self.n_bits = ones_bits if ones_bits is not None else dc_bits
+        else:
+            self.n_bits = max(max(ones) if ones else 0, max(dc) if dc else 0).bit_length()
+        self.__session_ones = ones - dc
+        self.__session_dc = dc
+        self.__session_covers = {}
+        self.__session_primes = None
+        self.__session_index = None
+        self.__session_coverage = None
+        return self.__session_update([], [], [])
+
+
+
+    def add_ones(self, terms):
+        """Add terms to the ON-set of the current session.
+
+        Args:
+            terms (iterable of int): the minterms to add.
+
+        Returns:
+            see: simplify.
+        """
+        terms = self.__session_terms(terms)
+        grown = terms - self.__session_ones - self.__session_dc
+        toggled = terms - self.__session_ones
+        self.__session_ones |= terms
+        self.__session_dc -= terms
+        return self.__session_update(grown, [], toggled)
+
+
+
+    def remove_ones(self, terms):
+        """Remove terms from the ON-set of the current session.
+
+        Args:
+            terms (iterable of int): the minterms to remove.
+
+        Returns:
+            see: simplify.
+        """
+        terms = self.__session_terms(terms)
+        shrunk = terms & self.__session_ones
+        self.__session_ones -= terms
+        return self.__session_update([], shrunk, shrunk)
+
+
+
+    def add_dc(self, terms):
+        """Add terms to the DC-set of the current session.
+
+        Args:
+            terms (iterable of int): the minterms to add.
+
+        Returns:
+            see: simplify.
+        """
+        terms = self.__session_terms(terms)
+        grown = terms - self.__session_ones - self.__session_dc
+        toggled = terms & self.__session_ones
+        self.__session_dc |= terms
+        self.__session_ones -= terms
+        return self.__session_update(grown, [], toggled)
+
+
+
+    def remove_dc(self, terms):
+        """Remove terms from the DC-set of the current session.
+
+        Args:
+            terms (iterable of int): the minterms to remove.
+
+        Returns:
+            see: simplify.
+        """
+        terms = self.__session_terms(terms)
+        shrunk = terms & self.__session_dc
+        self.__session_dc -= terms
+        return self.__session_update([], shrunk, [])
+
+
+
+    def __session_terms(self, terms):
+        """Check the terms of an update of the current session."""
+        if self.__session_ones is None:
+            raise ValueError("no session, call start_session first")
+        terms = set(terms)
+        if any(t < 0 or t >> self.n_bits for t in terms):
+            raise ValueError("term does not fit in %d bits" % self.n_bits)
+        return terms
+
+
+
+    def __session_update(self, grown, shrunk, toggled):
+        """Update the state of the session and return the new result.
+
+        Args:
+            grown (iterable of int): the minterms added to the union of the
+            ON- and the DC-set.
+            shrunk (iterable of int): the minterms removed from the union of
+            the ON- and the DC-set.
+            toggled (iterable of int): the minterms added to or removed from
+            the ON-set.
+
+        Returns:
+            see: simplify.
+        """
+        ctx = self.__begin_call()
+        try:
+            res = self.__session_solve(grown, shrunk, toggled)
+        finally:
+            self.__end_call(ctx)
+        return self.__finish_stats(res)
+
+
+
+    def __session_solve(self, grown, shrunk, toggled):
+        """Update the primes and the cover of the session, see __session_update."""
+        self.profile_cmp = 0
+        self.profile_xor = 0
+        self.profile_xnor = 0
+        self.status = 'complete'
+        ones = self.__session_ones
+        care = ones | self.__session_dc
+        if len(care) == 0:
+            self.__session_primes = None
+            self.__session_index = None
+            self.__session_coverage = None
+            return None
+
+        with self.stats.phase('primes'):
+            primes = self.__session_primes_update(grown, shrunk, care)
+
+        # The coverage of the primes that were kept only changes at the
+        # toggled minterms.
+        with self.stats.phase('coverage'):
+            coverage = self.__session_coverage_update(primes, toggled, ones)
+        self.__session_primes = primes
+        self.__session_coverage = coverage
+
+        cover_implicants = self.__solve_components(coverage)
+        on_index = dict((n, k) for k, n in enumerate(sorted(ones)))
+        cover_implicants = set(self.__term2str(t) for t in cover_implicants)
+        return self.__reduce_implicants(cover_implicants, on_index, self.__session_dc)
+
+
+
+    def __session_primes_update(self, grown, shrunk, care):
+        """Update the prime implicants of the session.
+
+        Args:
+            grown (iterable of int): see __session_update.
+            shrunk (iterable of int): see __session_update.
+            care (set of int): the new union of the ON- and the DC-set.
+
+        Returns:
+            The new set of packed prime implicants. self.__session_index is
+            updated to index them.
+        """
+        if self.__session_primes is None or self.use_xor:
+            primes = self.__get_prime_implicants(set((i, 0, 0, 0) for i in care))
+            index = cubeindex.CubeIndex(self.n_bits, primes)
+        else:
+            primes = set(self.__session_primes)
+            index = self.__session_index
+            if shrunk:
+                # The primes which contain a removed minterm are replaced by
+                # the maximal cubes around their remaining minterms.
+                invalid = set()
+                for m in shrunk:
+                    invalid.update(index.covering(m))
+                affected = set()
+                for p in invalid:
+                    affected.update(m for m in self.__minterms(p) if m in care)
+                    primes.discard(p)
+                    index.discard(p)
+                for m in affected:
+                    for q in self.__get_maximal_cubes(m, care):
+                        primes.add(q)
+                        index.add(q)
+            if grown:
+                # The new primes contain an added minterm; the old primes
+                # which are part of a new prime are no longer maximal.
+                new_primes = set()
+                for m in grown:
+                    new_primes |= self.__get_maximal_cubes(m, care)
+                for q in new_primes:
+                    for p in list(index.subcubes(q)):
+                        primes.discard(p)
+                        index.discard(p)
+                for q in new_primes:
+                    primes.add(q)
+                    index.add(q)
+        self.__session_index = index
+        self.stats.n_primes = len(primes)
+        return primes
+
+
+
+    def __session_coverage_update(self, primes, toggled, ones):
+        """Update the coverage of the prime implicants of the session.
+
+        Args:
+            primes (set of tuple): the new prime implicants.
+            toggled (iterable of int): see __session_update.
+            ones (set of int): the new ON-set.
+
+        Returns:
+            A dict which maps each prime implicant to the frozenset of the
+            ON-set minterms it covers.
+        """
+        old_coverage = self.__session_coverage or {}
+        touched_by = {}
+        for m in toggled:
+            for p in self.__session_index.covering(m):
+                touched_by.setdefault(p, []).append(m)
+        coverage = {}
+        for p in primes:
+            if p in old_coverage:
+                cov = old_coverage[p]
+                touched = touched_by.get(p)
+                if touched:
+                    cov = (cov | set(m for m in touched if m in ones)) - set(m for m in touched if m not in ones)
+                coverage[p] = cov
+            else:
+                coverage[p] = frozenset(m for m in self.__minterms(p) if m in ones)
+        st = self.stats
+        st.coverage_rows = len(ones)
+        st.coverage_columns = sum(1 for p in coverage if coverage[p])
+        st.coverage_entries = sum(len(c) for c in coverage.values())
+        return coverage
+
+
+
+    def __solve_components(self, coverage):
+        """Solve the covering problem of a session.
+
+        Args:
+            coverage (dict): maps each prime implicant to the frozenset of the
+            ON-set minterms it covers.
+
+        Returns:
+            A set of packed terms which covers the ON-set.
+
+        Rows which share no column are independent, so the problem is split
+        into connected components. The solution of each component is kept
+        and reused as long as its rows and columns do not change.
+        """
+        # Union-find over the minterms, joined by the primes covering them.
+        parent = {}
+        def find(m):
+            while parent[m] != m:
+                parent[m] = parent[parent[m]]
+                m = parent[m]
+            return m
+        for p in coverage:
+            for m in coverage[p]:
+                if m not in parent:
+                    parent[m] = m
+            root = None
+            for m in coverage[p]:
+                r = find(m)
+                if root is None:
+                    root = r
+                elif r != root:
+                    parent[r] = root
+        rows = dict()
+        cols = dict()
+        for m in parent:
+            rows.setdefault(find(m), []).append(m)
+        for p in coverage:
+            if coverage[p]:
+                cols.setdefault(find(next(iter(coverage[p]))), []).append(p)
+
+        res = set()
+        covers = {}
+        for root in rows:
+            key = (frozenset(rows[root]), frozenset(cols[root]))
+            if key in self.__session_covers:
+                selected = self.__session_covers[key]
+            else:
+                on_index = dict((n, k) for k, n in enumerate(sorted(rows[root])))
+                local = {}
+                for p in cols[root]:
+                    bits = 0
+                    for m in coverage[p]:
+                        bits |= 1 << on_index[m]
+                    local[p] = bits
+                with self.stats.phase('essential'):
+                    essential = self.__get_essential_implicants(local)
+                with self.stats.phase('cover'):
+                    selected = self.__get_minimum_cover(local, essential, len(on_index))
+            covers[key] = selected
+            res |= selected
+        self.__session_covers = covers
+        return res
+
+
+
+    def __get_maximal_cubes(self, m, care):
+        """Find all maximal cubes around a minterm.
+
+        Args:
+            m (int): a minterm of care.
+            care (set of int): the union of the ON- and the DC-set.
+
+        Returns:
+            The set of the packed cubes which contain m, are contained in
+            care and are not part of a bigger such cube.
+
+        The cubes are grown one free bit at a time. A cube is only tested
+        when all cubes obtained by fixing one of its free bits passed.
+        """
+        all_bits = (1 << self.n_bits) - 1
+        valid = set([0])
+        level = [0]
+        maximal = set()
+        while level:
+            next_level = set()
+            tested = set()
+            for free in level:
+                extended = False
+                zeros = all_bits & ~free
+                while zeros:
+                    bit = zeros & -zeros
+                    zeros ^= bit
+                    grown = free | bit
+                    if grown in next_level:
+                        extended = True
+                        continue
+                    if grown in tested:
+                        continue
+                    tested.add(grown)
+                    # All sub-cubes with one free bit less must be valid.
+                    rest = free
+                    ok = True
+                    while rest:
+                        low = rest & -rest
+                        rest ^= low
+                        if grown ^ low not in valid:
+                            ok = False
+                            break
+                    # The other half of the grown cube must be in care.
+                    if ok:
+                        ok = all(n in care for n in self.__minterms(((m ^ bit) & ~free, free, 0, 0)))
+                    if ok:
+                        next_level.add(grown)
+                        extended = True
+                if not extended:
+                    maximal.add((m & ~free, free, 0, 0))
+            valid = next_level
+            level = list(next_level)
+        return maximal
+
+
+
+    def __read_los(self, terms, lengths):
+        """Convert an iterable of string-encoded terms into a set of integers.
+
+        Args:
+            terms (iterable of str): the terms, see simplify_los.
+            lengths (set): updated with the lengths of the strings.
+        """
+        res = set()
+        for t in terms:
+            lengths.add(len(t))
+            res.add(int(t, 2))
+        return res
+
+
+
+    def __simplify_cached(self, ones, dc):
+        """Look up the result in self.cache or compute it.
+
+        Args:
+            ones (set of int): the minterms for which the output is '1'.
+            dc (set of int): the don't care minterms.
+
+        Returns:
+            see: simplify_los.
+        """
+        if self.cache is None:
+            return self.__simplify_packed(ones, dc)
+        self.profile_cmp = 0
+        self.profile_xor = 0
+        self.profile_xnor = 0
+        self.status = 'cached'
+        # Only results which ran to completion are stored: a cover found
+        # under the cover_budget or a deadline is not necessarily minimal.
+        return self.cache.get_or_compute(ones, dc, self.n_bits, self.use_xor,
+                                         lambda: self.__simplify_packed(ones, dc),
+                                         cacheable = lambda: self.status == 'complete',
+                                         options = self.__cache_options())
 
-    If the class was instantiiated with the use_xor set to True, then the
-    resulting boolean function may contain XOR and XNOR operators.
-    """
-    __version__ = "0.3"
 
 
+    def __cache_options(self):
+        """The options of the instance which are part of the cache key."""
+        return "method=%s,backend=%s,cover_budget=%r,prune_dc=%d,reduce_support=%d" % (
+                self.method, self.backend, self.cover_budget, self.prune_dc, self.reduce_support)
 
-    def __init__(self, use_xor = False):
-        """The class constructor.
 
-        Kwargs:
-            use_xor (bool): if True, try to use XOR and XNOR operations to give
-            a more compact return.
-        """
-        self.use_xor = use_xor  # Whether or not to use XOR and XNOR operations.
-        self.n_bits = 0         # number of bits (i.e. self.n_bits == len(ones[i]) for every i).
 
+    def __simplify_packed(self, ones, dc):
+        """The simplification algorithm for integer-encoded inputs.
 
+        Args:
+            ones (set of int): the minterms for which the output is '1'.
+            dc (set of int): the don't care minterms.
+
+        Returns:
+            see: simplify_los.
 
-    def __num2str(self, i):
+        self.n_bits must be set by the caller.
         """
-        Convert an integer to its bit-representation in a string.
+        self.profile_cmp = 0    # number of comparisons (for profiling)
+        self.profile_xor = 0    # number of comparisons (for profiling)
+        self.profile_xnor = 0   # number of comparisons (for profiling)
+        self.status = 'complete'
+
+        if not self.reduce_support:
+            return self.__simplify_function(ones, dc)
+
+        # Minimise the function over the inputs it depends on.
+        st = self.stats
+        n_bits = self.n_bits
+        support = self.__get_support(ones, dc)
+        st.support = support
+        if len(support) == n_bits:
+            st.symmetric_groups = self.__get_symmetric_groups(ones, dc)
+            return self.__simplify_function(ones, dc)
+        r_ones = set(self.__project(m, support) for m in ones)
+        r_dc = set(self.__project(m, support) for m in dc)
+        self.n_bits = len(support)
+        try:
+            st.symmetric_groups = [[support[b] for b in g]
+                                   for g in self.__get_symmetric_groups(r_ones, r_dc)]
+            res = self.__simplify_function(r_ones, r_dc)
+        finally:
+            self.n_bits = n_bits
+        full = ['-'] * n_bits
+        expanded = set()
+        for t in res:
+            # Character k of a term stands for bit n_bits - 1 - k.
+            for p, b in enumerate(support):
+                full[n_bits - 1 - b] = t[len(support) - 1 - p]
+            expanded.add("".join(full))
+        return expanded
+
+
+
+    def __get_support(self, ones, dc):
+        """Return the inputs a function depends on.
 
         Args:
-            i (int): the number to convert.
+            ones (set of int): the minterms of the ON-set.
+            dc (set of int): the don't care minterms.
 
         Returns:
-            The binary string representation of the parameter i.
+            The sorted list of the bit positions b for which the function
+            differs between the cofactors of b = 0 and b = 1. A don't care
+            only matches a don't care, so a minimum cover of the function
+            over the support is a minimum cover of the whole function.
         """
-        x = ['1' if i & (1 << k) else '0' for k in range(self.n_bits - 1, -1, -1)]
-        return "".join(x)
+        on = ones - dc
+        res = []
+        for b in range(self.n_bits):
+            bit = 1 << b
+            if any(m ^ bit not in on for m in on) or any(m ^ bit not in dc for m in dc):
+                res.append(b)
+        return res
 
 
 
-    def simplify(self, ones, dc = [], num_bits = None):
-        """Simplify a list of terms.
+    def __get_symmetric_groups(self, ones, dc):
+        """Find the groups of symmetric inputs.
 
         Args:
-            ones (list of int): list of integers that describe when the output
-            function is '1', e.g. [1, 2, 6, 8, 15].
-
-        Kwargs:
-            dc (list of int): list of numbers for which we don't care if they
-            have one or zero in the output.
+            ones (set of int): the minterms of the ON-set.
+            dc (set of int): the don't care minterms.
 
         Returns:
-            see: simplify_los.
+            A list of the groups of two or more bit positions, each sorted,
+            such that swapping the values of any two bits of a group does not
+            change the function. Symmetry is transitive, so each bit is only
+            compared with the first bit of each group.
+        """
+        on = ones - dc
+        groups = []
+        for b in range(self.n_bits):
+            for g in groups:
+                pair = (1 << g[0]) | (1 << b)
+                if all(m & pair in (0, pair) or m ^ pair in on for m in on) and \
+                        all(m & pair in (0, pair) or m ^ pair in dc for m in dc):
+                    g.append(b)
+                    break
+            else:
+                groups.append([b])
+        return [g for g in groups if len(g) > 1]
 
-        Example:
-            ones = [2, 6, 10, 14]
-            dc = []
 
-            This will produce the ouput: ['--10']
-            This means x = b1 & ~b0, (bit1 AND NOT bit0)
 
-        Example:
-            ones = [1, 2, 5, 6, 9, 10, 13, 14]
-            dc = []
+    def __project(self, m, support):
+        """Map a minterm to the bits of support, the lowest one first."""
+        res = 0
+        for p, b in enumerate(support):
+            res |= (m >> b & 1) << p
+        return res
 
-            This will produce the ouput: ['--^^'].
-            In other words, x = b1 ^ b0, (bit1 XOR bit0).
-        """
-        terms = ones + dc
-        if len(terms) == 0:
-            return None
 
-        # Calculate the number of bits to use
-        # Needed internally by __num2str()
-        if num_bits is not None:
-            self.n_bits = num_bits
-        else:
-            self.n_bits = int(math.ceil(math.log(max(terms) + 1, 2)))
 
-        # Generate the sets of ones and dontcares
-        ones = [self.__num2str(i) for i in ones]
-        dc = [self.__num2str(i) for i in dc]
+    def __simplify_function(self, ones, dc):
+        """Minimise a function over all of its self.n_bits inputs.
 
-        return self.simplify_los(ones, dc)
+        Args:
+            ones (set of int): the minterms for which the output is '1'.
+            dc (set of int): the don't care minterms.
 
+        Returns:
+            see: simplify_los.
+        """
+        st = self.stats
+        on_index = dict((n, k) for k, n in enumerate(sorted(ones - dc)))
+        if self.method == "heuristic":
+            # The heuristic cover is the initial cover; the other primes met
+            # by the minimiser and XOR terms formed from the cubes of the
+            # cover are offered as alternatives.
+            with st.phase('primes'):
+                essential_implicants, prime_implicants = self.__get_heuristic_cover(ones - dc, dc)
+                prime_implicants |= essential_implicants
+                if self.use_xor:
+                    prime_implicants |= self.__get_xor_pairs(essential_implicants)
+            coverage = self.__get_coverage_matrix(prime_implicants, on_index)
+            if not essential_implicants:
+                essential_implicants = set([(0, (1 << self.n_bits) - 1, 0, 0)])
+        else:
+            # First step of Quine-McCluskey method.
+            with st.phase('primes'):
+                table = self.__context().table
+                if self.prune_dc and dc and self.backend == "python" and self.workers <= 1:
+                    prime_implicants = self.__get_on_prime_implicants(ones - dc, ones | dc)
+                elif table is not None and table[0] == self.n_bits and self.backend == "c":
+                    prime_implicants = self.__get_table_prime_implicants(table[1], len(ones) + len(dc))
+                elif self.backend == "zdd" and not self.use_xor:
+                    # The primes are read from the ZDD one at a time while
+                    # the coverage is calculated.
+                    terms = set((i, 0, 0, 0) for i in itertools.chain(ones, dc))
+                    prime_implicants = self.__get_zdd_prime_implicants(terms)
+                else:
+                    terms = set((i, 0, 0, 0) for i in itertools.chain(ones, dc))
+                    prime_implicants = self.__get_prime_implicants(terms)
 
+            # Calculate the coverage of each prime implicant as a bitset over
+            # the minterms of the ON-set.
+            coverage = self.__get_coverage_matrix(prime_implicants, on_index)
 
-    def simplify_los(self, ones, dc = [], num_bits = None):
-        """The simplification algorithm for a list of string-encoded inputs.
+            # Remove essential terms.
+            with st.phase('essential'):
+                essential_implicants = self.__get_essential_implicants(coverage)
 
-        Args:
-            ones (list of str): list of strings that describe when the output
-            function is '1', e.g. ['0001', '0010', '0110', '1000', '1111'].
+        # Select a minimum cover, starting from the essential implicants.
+        self.__report('cover')
+        with st.phase('cover'):
+            cover_implicants = self.__get_minimum_cover(coverage, essential_implicants, len(on_index))
+        cover_implicants = set(self.__term2str(t) for t in cover_implicants)
 
-        Kwargs:
-            dc: (list of str): list of strings that define the don't care
-            combinations.
+        # Perform further reduction on essential implicants
+        reduced_implicants = self.__reduce_implicants(cover_implicants, on_index, dc)
 
-        Returns:
-            Returns a set of strings which represent the reduced minterms.  The
-            length of the strings is equal to the number of bits in the input.
-            Character 0 of the output string stands for the most significant
-            bit, Character n - 1 (n is the number of bits) stands for the least
-            significant bit.
+        return reduced_implicants
 
-            The following characters are allowed in the return string:
-              '-' don't care: this bit can be either zero or one.
-              '1' the bit must be one.
-              '0' the bit must be zero.
-              '^' all bits with the caret are XOR-ed together.
-              '~' all bits with the tilde are XNOR-ed together.
 
-        Example:
-            ones = ['0010', '0110', '1010', '1110']
-            dc = []
 
-            This will produce the ouput: ['--10'].
-            In other words, x = b1 & ~b0, (bit1 AND NOT bit0).
+    def __get_coverage_matrix(self, prime_implicants, on_index):
+        """Calculate the coverage of each prime implicant.
 
-        Example:
-            ones = ['0001', '0010', '0101', '0110', '1001', '1010' '1101', '1110']
-            dc = []
+        Args:
+            prime_implicants (iterable of tuple): the packed prime
+            implicants. They are read once, so this may be an iterator.
 
-            This will produce the ouput: ['--^^'].
-            In other words, x = b1 ^ b0, (bit1 XOR bit0).
+            on_index (dict): see __get_coverage.
+
+        Returns:
+            A dict which maps each prime implicant that covers at least one
+            minterm of the ON-set to its coverage bitset. The size of the
+            matrix is recorded in self.stats.
+
+        Prime implicants of don't cares only can never be part of a cover
+        and are not kept.
         """
-        self.profile_cmp = 0    # number of comparisons (for profiling)
-        self.profile_xor = 0    # number of comparisons (for profiling)
-        self.profile_xnor = 0   # number of comparisons (for profiling)
+        st = self.stats
+        with st.phase('coverage'):
+            coverage = {}
+            n_primes = 0
+            for t in prime_implicants:
+                if t in coverage:
+                    continue
+                n_primes += 1
+                c = self.__get_coverage(t, on_index)
+                if c:
+                    coverage[t] = c
+            st.n_primes = n_primes
+            st.coverage_rows = len(on_index)
+            st.coverage_columns = len(coverage)
+            st.coverage_entries = sum(_popcount(c) for c in coverage.values())
+        return coverage
+
+
+
+    def __get_heuristic_cover(self, ones, dc):
+        """Find a cover with the heuristic minimiser.
 
-        terms = set(ones) | set(dc)
-        if len(terms) == 0:
-            return None
+        Args:
+            ones (set of int): the ON-set minterms, disjoint from dc.
+            dc (set of int): the don't care minterms.
 
-        # Calculate the number of bits to use
-        if num_bits is not None:
-            self.n_bits = num_bits
-        else:
-            self.n_bits = max(len(i) for i in terms)
-            if self.n_bits != min(len(i) for i in terms):
-                return None
+        Returns:
+            A tuple (cover, primes) of the set of packed cubes which covers
+            ones and the set of all prime implicants met by the minimiser.
+        """
+        minimizer = heuristic.Espresso(ones, dc, self.n_bits,
+                                       rank = lambda t, n: self.__get_term_rank(t, n),
+                                       cost = self.__get_term_cost,
+                                       stop = self.__out_of_budget)
+        return set(minimizer.minimize()), minimizer.primes
 
-        # First step of Quine-McCluskey method.
-        prime_implicants = self.__get_prime_implicants(terms)
 
-        # Remove essential terms.
-        essential_implicants = self.__get_essential_implicants(prime_implicants, set(dc))
 
-        # Perform further reduction on essential implicants
-        reduced_implicants = self.__reduce_implicants(essential_implicants, set(dc))
+    def __get_xor_pairs(self, cubes):
+        """Combine pairs of cubes with the same mask into XOR and XNOR terms.
 
-        return reduced_implicants
+        Args:
+            cubes (set of tuple): a set of packed cubes.
+
+        Returns:
+            The set of the combined terms. Each term covers exactly the
+            minterms of its two cubes.
+        """
+        by_mask = dict()
+        for c in cubes:
+            by_mask.setdefault(c[1], []).append(c)
+        res = set()
+        for group in by_mask.values():
+            group.sort()
+            for i, t1 in enumerate(group):
+                for t2 in group[i + 1:]:
+                    for t12 in (self.__reduce_simple_xor_terms(t1, t2), self.__reduce_simple_xnor_terms(t1, t2)):
+                        if t12 is not None:
+                            res.add(t12)
+        return res
 
 
 
@@ -203,28 +1941,18 @@ class QuineMcCluskey:
         """Try to reduce two terms t1 and t2, by combining them as XOR terms.
 
         Args:
-            t1 (str): a term.
-            t2 (str): a term.
+            t1 (tuple of int): a packed term.
+            t2 (tuple of int): a packed term.
 
         Returns:
             The reduced term or None if the terms cannot be reduced.
         """
-        difft10 = 0
-        difft20 = 0
-        ret = []
-        for (t1c, t2c) in zip(t1, t2):
-            if t1c == '^' or t2c == '^' or t1c == '~' or t2c == '~':
-                return None
-            elif t1c != t2c:
-                ret.append('^')
-                if t2c == '0':
-                    difft10 += 1
-                else:
-                    difft20 += 1
-            else:
-                ret.append(t1c)
-        if difft10 == 1 and difft20 == 1:
-            return "".join(ret)
+        if t1[2] or t1[3] or t2[2] or t2[3] or t1[1] != t2[1]:
+            return None
+        diff = t1[0] ^ t2[0]
+        # Exactly one bit must go from 1 to 0 and one bit from 0 to 1.
+        if _popcount(diff) == 2 and _popcount(t1[0] & diff) == 1:
+            return (t1[0] & ~diff, t1[1], diff, 0)
         return None
 
 
@@ -233,49 +1961,85 @@ class QuineMcCluskey:
         """Try to reduce two terms t1 and t2, by combining them as XNOR terms.
 
         Args:
-            t1 (str): a term.
-            t2 (str): a term.
+            t1 (tuple of int): a packed term.
+            t2 (tuple of int): a packed term.
 
         Returns:
             The reduced term or None if the terms cannot be reduced.
         """
-        difft10 = 0
-        difft20 = 0
-        ret = []
-        for (t1c, t2c) in zip(t1, t2):
-            if t1c == '^' or t2c == '^' or t1c == '~' or t2c == '~':
-                return None
-            elif t1c != t2c:
-                ret.append('~')
-                if t1c == '0':
-                    difft10 += 1
-                else:
-                    difft20 += 1
-            else:
-                ret.append(t1c)
-        if (difft10 == 2 and difft20 == 0) or (difft10 == 0 and difft20 == 2):
-            return "".join(ret)
+        if t1[2] or t1[3] or t2[2] or t2[3] or t1[1] != t2[1]:
+            return None
+        diff = t1[0] ^ t2[0]
+        # Both bits must differ in the same direction.
+        if _popcount(diff) == 2 and (t1[0] & diff == 0 or t1[0] & diff == diff):
+            return (t1[0] & ~diff, t1[1], 0, diff)
         return None
 
 
 
-    def __get_prime_implicants(self, terms):
+    def __get_table_prime_implicants(self, table, n_terms):
+        """Generate the prime implicants of a mapped truth table with the c
+        backend.
+
+        Args:
+            table (memoryview): the entries of a truthtable file of
+            self.n_bits inputs.
+            n_terms (int): the number of ON and DC minterms of the table.
+
+        Returns:
+            see: __get_prime_implicants.
+        """
+        pi, n_cmp, n_xor, n_xnor = _qm.table_prime_implicants(table, self.n_bits, self.use_xor,
+                                                                 self.__native_checkpoint)
+        self.profile_cmp += n_cmp
+        self.profile_xor += n_xor
+        self.profile_xnor += n_xnor
+        self.stats.peak_terms = max(self.stats.peak_terms, n_terms, len(pi))
+        return pi
+
+
+
+    def __get_prime_implicants(self, terms, tags = None):
         """Simplify the set 'terms'.
 
         Args:
-            terms (set of str): set of strings representing the minterms of
-            ones and dontcares.
+            terms (set of tuple): set of packed terms (see __term2str)
+            representing the minterms of ones and dontcares.
+
+        Kwargs:
+            tags (dict): for multi-output functions, maps each term to the
+            bitmask of the outputs it is an implicant of. The tags of the
+            new terms are added to the dict (see __merge_tags). Tagged terms
+            always use the serial "python" merge rounds.
 
         Returns:
-            A list of prime implicants. These are the minterms that cannot be
-            reduced with step 1 of the Quine McCluskey method.
+            A set of packed prime implicants. These are the minterms that
+            cannot be reduced with step 1 of the Quine McCluskey method.
 
         This is the very first step in the Quine McCluskey algorithm. This
         generates all prime implicants, whether they are redundant or not.
+
+        If the call is cut short (see __out_of_budget), the implicants found
+        so far are returned instead. They still cover all terms. The c
+        backend checks before each merge round and every 65536 terms of a
+        round; the numpy backend always runs its merge rounds to completion.
         """
 
+        if tags is None and self.backend == "zdd" and not self.use_xor:
+            return set(self.__get_zdd_prime_implicants(terms))
+
+        if tags is None and self.backend == "c" and self.n_bits <= _qm.MAX_BITS:
+            pi, n_cmp, n_xor, n_xnor = _qm.get_prime_implicants(terms, self.n_bits, self.use_xor,
+                                                               self.__native_checkpoint)
+            self.profile_cmp += n_cmp
+            self.profile_xor += n_xor
+            self.profile_xnor += n_xnor
+            self.stats.peak_terms = max(self.stats.peak_terms, len(terms), len(pi))
+            return pi
+
         # Sort and remove duplicates.
         n_groups = self.n_bits + 1
+        all_bits = (1 << self.n_bits) - 1
         marked = set()
 
         # Group terms into the list groups.
@@ -285,126 +2049,461 @@ class QuineMcCluskey:
         # groups[i] contains exactly i ones.
         groups = [set() for i in range(n_groups)]
         for t in terms:
-            n_bits = t.count('1')
+            n_bits = _popcount(t[0])
             groups[n_bits].add(t)
         if self.use_xor:
             # Add 'simple' XOR and XNOR terms to the set of terms.
             # Simple means the terms can be obtained by combining just two
-            # bits.
+            # bits. The partners of a term differ in exactly two bits, so
+            # they are looked up by flipping each pair of bits: a '1' and a
+            # higher '0' in the same group for XOR (one probe per pair), two
+            # '0's in the group with two more ones for XNOR.
             for gi, group in enumerate(groups):
                 for t1 in group:
-                    for t2 in group:
-                        t12 = self.__reduce_simple_xor_terms(t1, t2)
-                        if t12 != None:
-                            terms.add(t12)
+                    if self.__out_of_budget(len(terms)):
+                        break
+                    value, mask, xor_mask, xnor_mask = t1
+                    if xor_mask or xnor_mask:
+                        continue
+                    zeros = all_bits & ~(value | mask)
+                    pairs = []
+                    ones = value
+                    while ones:
+                        b1 = ones & -ones
+                        ones ^= b1
+                        higher = zeros & ~(2 * b1 - 1)
+                        while higher:
+                            b2 = higher & -higher
+                            higher ^= b2
+                            t2 = (value ^ b1 ^ b2, mask, 0, 0)
+                            if t2 in group:
+                                pairs.append((t2, (value & ~b1, mask, b1 | b2, 0)))
                     if gi < n_groups - 2:
-                        for t2 in groups[gi + 2]:
-                            t12 = self.__reduce_simple_xnor_terms(t1, t2)
-                            if t12 != None:
+                        group2 = groups[gi + 2]
+                        rest = zeros
+                        while rest:
+                            b1 = rest & -rest
+                            rest ^= b1
+                            higher = rest
+                            while higher:
+                                b2 = higher & -higher
+                                higher ^= b2
+                                t2 = (value | b1 | b2, mask, 0, 0)
+                                if t2 in group2:
+                                    pairs.append((t2, (value, mask, 0, b1 | b2)))
+                    for t2, t12 in pairs:
+                        if tags is not None:
+                            if not tags[t1] & tags[t2]:
+                                continue
+                            tags[t12] = tags[t1] & tags[t2]
+                        terms.add(t12)
+                else:
+                    continue
+                break
+
+        if tags is None and self.backend == "numpy" and self.n_bits <= numpy_backend.MAX_BITS:
+            pi, n_cmp, n_xor, n_xnor = numpy_backend.get_prime_implicants(terms, self.n_bits)
+            self.profile_cmp += n_cmp
+            self.profile_xor += n_xor
+            self.profile_xnor += n_xnor
+            self.stats.peak_terms = max(self.stats.peak_terms, len(terms), len(pi))
+            return pi
+
+        # The merge rounds may be spread across a pool of worker processes.
+        merger = None
+        if (tags is None and self.workers > 1 and self.n_bits <= parallel.MAX_BITS
+                and parallel.shared_memory is not None):
+            merger = parallel.MergePool(self.workers, self.n_bits)
+        try:
+            done = False
+            while not done and not self.__out_of_budget(len(marked) + len(terms)):
+                # Group terms into groups.
+                # groups is a list of length n_groups.
+                # Each element of groups is a set of terms with the same
+                # number of ones.  In other words, each term contained in the
+                # set groups[i] contains exactly i ones.
+                groups = dict()
+                for t in terms:
+                    n_ones = _popcount(t[0])
+                    n_xor  = _popcount(t[2])
+                    n_xnor = _popcount(t[3])
+                    # The algorithm can not cope with mixed XORs and XNORs in
+                    # one expression.
+                    assert n_xor == 0 or n_xnor == 0
+
+                    key = (n_ones, n_xor, n_xnor)
+                    if key not in groups:
+                        groups[key] = set()
+                    groups[key].add(t)
+
+                if merger is not None and len(terms) >= parallel.MIN_TERMS:
+                    terms, used, n_cmp, n_xor, n_xnor = merger.merge_round(groups)
+                    self.profile_cmp += n_cmp
+                    self.profile_xor += n_xor
+                    self.profile_xnor += n_xnor
+                else:
+                    terms, used = self.__merge_round(groups, all_bits, tags)
+
+                # Add the unused terms to the list of marked terms
+                n_marked = len(marked)
+                n_in = sum(len(g) for g in groups.values())
+                for g in list(groups.values()):
+                    marked |= g - used
+                st = self.stats
+                st.terms_per_round.append(n_in)
+                st.primes_per_round.append(len(marked) - n_marked)
+                st.peak_terms = max(st.peak_terms, n_marked + n_in, len(marked) + len(terms))
+                self.__report('primes')
+
+                if len(used) == 0:
+                    done = True
+        finally:
+            if merger is not None:
+                merger.close()
+
+        # Prepare the list of prime implicants. If the rounds were cut
+        # short, the terms of the last round are not merged any further.
+        return marked | terms
+
+
+
+    def __get_on_prime_implicants(self, ones, care):
+        """Compute the prime implicants which cover a minterm of the ON-set.
+
+        Args:
+            ones (set of int): the minterms of the ON-set.
+            care (set of int): the union of the ON- and the DC-set.
+
+        Returns:
+            The set of the packed prime implicants of care which cover at
+            least one minterm of ones. If the call is cut short, the
+            implicants found so far are returned; they cover ones.
+
+        The merge rounds are those of __get_prime_implicants, restricted to
+        the terms with a minterm of the ON-set. A term is only ever merged
+        with a term of the same shape, and each round holds all implicants
+        of its shapes, so a partner which covers only don't cares is
+        checked directly against care (see __in_care) instead of being
+        generated in the previous rounds.
+        """
+        all_bits = (1 << self.n_bits) - 1
+        memo = {}   # The implicant test results, see __in_care.
+
+        terms = set((m, 0, 0, 0) for m in ones)
+        if self.use_xor:
+            # The simple XOR and XNOR terms around the ON-set minterms. A
+            # partner may be on either side of the pair of bits.
+            for value in ones:
+                if self.__out_of_budget(len(terms)):
+                    break
+                bits = [1 << b for b in range(self.n_bits)]
+                for i, b1 in enumerate(bits):
+                    for b2 in bits[i + 1:]:
+                        pair = b1 | b2
+                        both = value & pair
+                        if both == 0:
+                            if value | pair in care:
+                                terms.add((value, 0, 0, pair))
+                        elif both == pair:
+                            if value & ~pair in care:
+                                terms.add((value & ~pair, 0, 0, pair))
+                        elif value ^ pair in care:
+                            terms.add((value & ~pair, 0, pair, 0))
+
+        marked = set()
+        st = self.stats
+        while terms and not self.__out_of_budget(len(marked) + len(terms)):
+            # The terms are implicants, and the halves of the partners of
+            # the next round are often terms of this round.
+            memo.update(dict.fromkeys(terms, True))
+            new_terms, used = self.__merge_on_round(terms, all_bits, care, memo)
+            n_marked = len(marked)
+            marked |= terms - used
+            st.terms_per_round.append(len(terms))
+            st.primes_per_round.append(len(marked) - n_marked)
+            st.peak_terms = max(st.peak_terms, n_marked + len(terms), len(marked) + len(new_terms))
+            self.__report('primes')
+            terms = new_terms
+        return marked | terms
+
+
+
+    def __merge_on_round(self, terms, all_bits, care, memo):
+        """Perform one merge round on the terms with an ON-set minterm.
+
+        Args:
+            terms (set of tuple): the packed terms of this round which cover
+            a minterm of the ON-set.
+
+            all_bits (int): a mask with all n_bits bits set.
+
+            care (set of int): the union of the ON- and the DC-set.
+
+            memo (dict): the implicant test results (see __in_care), which
+            include the terms.
+
+        Returns:
+            A tuple (terms, used) as __merge_round. Unlike there, each term
+            looks for partners on both sides of each bit, since a partner
+            which covers only don't cares is not in terms.
+        """
+        new_terms = set()
+        used = set()
+        ctx = self.__context()
+
+        for t1 in terms:
+            if self.__out_of_budget():
+                break
+            value, mask, xor_mask, xnor_mask = t1
+            fixed = all_bits & ~(mask | xor_mask | xnor_mask)
+            bits = fixed
+            while bits:
+                bit = bits & -bits
+                bits ^= bit
+                ctx.profile_cmp += 1
+                t2 = (value ^ bit, mask, xor_mask, xnor_mask)
+                found = memo.get(t2)
+                if found is None:
+                    found = self.__in_care(t2, care, memo)
+                if found:
+                    used.add(t1)
+                    new_terms.add((value & ~bit, mask | bit, xor_mask, xnor_mask))
+            if xor_mask or xnor_mask:
+                # As in __merge_round, a XOR (XNOR) term with a '0' merges
+                # with its complement with a '1' there into a XOR (XNOR)
+                # term, and only the former is used up. With a '1', the
+                # term is the complement of such a merge.
+                is_xor = xor_mask != 0
+                parity = xor_mask | xnor_mask
+                bits = fixed
+                while bits:
+                    bit = bits & -bits
+                    bits ^= bit
+                    if is_xor:
+                        ctx.profile_xor += 1
+                    else:
+                        ctx.profile_xnor += 1
+                    v = value ^ bit
+                    partner = (v, mask, 0, parity) if is_xor else (v, mask, parity, 0)
+                    found = memo.get(partner)
+                    if found is None:
+                        found = self.__in_care(partner, care, memo)
+                    if not found:
+                        continue
+                    if value & bit:
+                        new_terms.add((v, mask, 0, parity | bit) if is_xor else (v, mask, parity | bit, 0))
+                    else:
+                        used.add(t1)
+                        new_terms.add((value, mask, parity | bit, 0) if is_xor else (value, mask, 0, parity | bit))
+        return new_terms, used
+
+
+
+    def __in_care(self, term, care, memo):
+        """Return True if all minterms of a packed term are in care.
+
+        The term is split as it was formed by the merge rounds: on a '-'
+        first, then on a '^' or '~' while more than two of them are left.
+        The results of the terms which are not minterms are kept in memo.
+        """
+        value, mask, xor_mask, xnor_mask = term
+        if not (mask or xor_mask or xnor_mask):
+            return value in care
+        res = memo.get(term)
+        if res is not None:
+            return res
+        parity = xor_mask | xnor_mask
+        if mask:
+            bit = mask & -mask
+            res = self.__in_care((value, mask ^ bit, xor_mask, xnor_mask), care, memo) and \
+                    self.__in_care((value | bit, mask ^ bit, xor_mask, xnor_mask), care, memo)
+        elif _popcount(parity) > 2:
+            # More than two XOR (XNOR) bits: the term with a '0' and the
+            # complement with a '1' in the lowest of them.
+            bit = parity & -parity
+            rest = parity ^ bit
+            if xor_mask:
+                halves = ((value, 0, rest, 0), (value | bit, 0, 0, rest))
+            else:
+                halves = ((value, 0, 0, rest), (value | bit, 0, rest, 0))
+            res = all(self.__in_care(h, care, memo) for h in halves)
+        else:
+            b1 = parity & -parity
+            b2 = parity ^ b1
+            if xor_mask:
+                res = value | b1 in care and value | b2 in care
+            else:
+                res = value in care and value | parity in care
+        memo[term] = res
+        return res
+
+
+
+    def __get_zdd_prime_implicants(self, terms):
+        """Compute the prime implicants with the zdd module.
+
+        Args:
+            terms (set of tuple): the packed minterms of ones and dontcares.
+
+        Returns:
+            An iterator over the packed prime implicants. They are generated
+            from the ZDD one at a time, so the primes are never held in
+            memory all at once, unless the caller collects them.
+
+        If the call is cut short while the diagrams are built, the minterms
+        themselves are returned. If there are more than max_primes primes,
+        the first max_primes of them are returned followed by the
+        minterms.
+        """
+        manager = zdd.Manager(self.n_bits)
+        f = manager.from_minterms(t[0] for t in terms)
+        try:
+            primes = manager.primes(f, stop = self.__out_of_budget)
+        except zdd.Stopped:
+            return iter(terms)
+        n_primes = manager.count(primes)
+        self.stats.peak_terms = max(self.stats.peak_terms, len(terms), n_primes)
+        max_primes = self.__context().max_primes
+        if max_primes is not None and self.__out_of_budget(n_primes):
+            return itertools.chain(itertools.islice(manager.cubes(primes), max_primes), terms)
+        return manager.cubes(primes)
+
+
+
+    def __merge_round(self, groups, all_bits, tags = None):
+        """Perform one merge round of the Quine McCluskey method.
+
+        Args:
+            groups (dict): maps each (n_ones, n_xor, n_xnor) key to the set of
+            packed terms with this number of ones, XORs and XNORs.
+
+            all_bits (int): a mask with all n_bits bits set.
+
+        Kwargs:
+            tags (dict): the output tags of the terms, or None (see
+            __get_prime_implicants).
+
+        Returns:
+            A tuple (terms, used) of the set of newly created terms and the
+            set of terms which have been merged into a new term.
+        """
+        terms = set()           # The set of new created terms
+        used = set()            # The set of used terms
+        ctx = self.__context()  # The profile counters of this thread
+
+        # Find prime implicants
+        for key in groups:
+            if self.__out_of_budget():
+                return terms, used
+            key_next = (key[0]+1, key[1], key[2])
+            if key_next in groups:
+                group_next = groups[key_next]
+                for t1 in groups[key]:
+                    # Optimisation:
+                    # The Quine-McCluskey algorithm compares t1 with
+                    # each element of the next group. (Normal approach)
+                    # But in reality it is faster to construct all
+                    # possible permutations of t1 by adding a '1' in
+                    # opportune positions and check if this new term is
+                    # contained in the set groups[key_next].
+                    value, mask, xor_mask, xnor_mask = t1
+                    zeros = all_bits & ~(value | mask | xor_mask | xnor_mask)
+                    while zeros:
+                        bit = zeros & -zeros
+                        zeros ^= bit
+                        ctx.profile_cmp += 1
+                        t2 = (value | bit, mask, xor_mask, xnor_mask)
+                        if t2 in group_next:
+                            t12 = (value, mask | bit, xor_mask, xnor_mask)
+                            if tags is None:
+                                used.add(t1)
+                                used.add(t2)
+                                terms.add(t12)
+                            else:
+                                self.__merge_tags(t1, t2, t12, tags, terms, used)
+
+        # Find XOR combinations
+        for key in [k for k in groups if k[1] > 0]:
+            if self.__out_of_budget():
+                return terms, used
+            key_complement = (key[0] + 1, key[2], key[1])
+            if key_complement in groups:
+                group_complement = groups[key_complement]
+                for t1 in groups[key]:
+                    value, mask, xor_mask, _ = t1
+                    zeros = all_bits & ~(value | mask | xor_mask)
+                    while zeros:
+                        bit = zeros & -zeros
+                        zeros ^= bit
+                        ctx.profile_xor += 1
+                        # The complement has the '^' replaced by '~'.
+                        t2 = (value | bit, mask, 0, xor_mask)
+                        if t2 in group_complement:
+                            t12 = (value, mask, xor_mask | bit, 0)
+                            if tags is None:
+                                used.add(t1)
                                 terms.add(t12)
+                            else:
+                                self.__merge_tags(t1, t2, t12, tags, terms, used, False)
+        # Find XNOR combinations
+        for key in [k for k in groups if k[2] > 0]:
+            if self.__out_of_budget():
+                return terms, used
+            key_complement = (key[0] + 1, key[2], key[1])
+            if key_complement in groups:
+                group_complement = groups[key_complement]
+                for t1 in groups[key]:
+                    value, mask, _, xnor_mask = t1
+                    zeros = all_bits & ~(value | mask | xnor_mask)
+                    while zeros:
+                        bit = zeros & -zeros
+                        zeros ^= bit
+                        ctx.profile_xnor += 1
+                        # The complement has the '~' replaced by '^'.
+                        t2 = (value | bit, mask, xnor_mask, 0)
+                        if t2 in group_complement:
+                            t12 = (value, mask, 0, xnor_mask | bit)
+                            if tags is None:
+                                used.add(t1)
+                                terms.add(t12)
+                            else:
+                                self.__merge_tags(t1, t2, t12, tags, terms, used, False)
+        return terms, used
 
-        done = False
-        while not done:
-            # Group terms into groups.
-            # groups is a list of length n_groups.
-            # Each element of groups is a set of terms with the same
-            # number of ones.  In other words, each term contained in the
-            # set groups[i] contains exactly i ones.
-            groups = dict()
-            for t in terms:
-                n_ones = t.count('1')
-                n_xor  = t.count('^')
-                n_xnor = t.count('~')
-                # The algorithm can not cope with mixed XORs and XNORs in
-                # one expression.
-                assert n_xor == 0 or n_xnor == 0
-
-                key = (n_ones, n_xor, n_xnor)
-                if key not in groups:
-                    groups[key] = set()
-                groups[key].add(t)
-
-            terms = set()           # The set of new created terms
-            used = set()            # The set of used terms
-
-            # Find prime implicants
-            for key in groups:
-                key_next = (key[0]+1, key[1], key[2])
-                if key_next in groups:
-                    group_next = groups[key_next]
-                    for t1 in groups[key]:
-                        # Optimisation:
-                        # The Quine-McCluskey algorithm compares t1 with
-                        # each element of the next group. (Normal approach)
-                        # But in reality it is faster to construct all
-                        # possible permutations of t1 by adding a '1' in
-                        # opportune positions and check if this new term is
-                        # contained in the set groups[key_next].
-                        for i, c1 in enumerate(t1):
-                            if c1 == '0':
-                                self.profile_cmp += 1
-                                t2 = t1[:i] + '1' + t1[i+1:]
-                                if t2 in group_next:
-                                    t12 = t1[:i] + '-' + t1[i+1:]
-                                    used.add(t1)
-                                    used.add(t2)
-                                    terms.add(t12)
-
-            # Find XOR combinations
-            for key in [k for k in groups if k[1] > 0]:
-                key_complement = (key[0] + 1, key[2], key[1])
-                if key_complement in groups:
-                    for t1 in groups[key]:
-                        t1_complement = t1.replace('^', '~')
-                        for i, c1 in enumerate(t1):
-                            if c1 == '0':
-                                self.profile_xor += 1
-                                t2 = t1_complement[:i] + '1' + t1_complement[i+1:]
-                                if t2 in groups[key_complement]:
-                                    t12 = t1[:i] + '^' + t1[i+1:]
-                                    used.add(t1)
-                                    terms.add(t12)
-            # Find XNOR combinations
-            for key in [k for k in groups if k[2] > 0]:
-                key_complement = (key[0] + 1, key[2], key[1])
-                if key_complement in groups:
-                    for t1 in groups[key]:
-                        t1_complement = t1.replace('~', '^')
-                        for i, c1 in enumerate(t1):
-                            if c1 == '0':
-                                self.profile_xnor += 1
-                                t2 = t1_complement[:i] + '1' + t1_complement[i+1:]
-                                if t2 in groups[key_complement]:
-                                    t12 = t1[:i] + '~' + t1[i+1:]
-                                    used.add(t1)
-                                    terms.add(t12)
-
-            # Add the unused terms to the list of marked terms
-            for g in list(groups.values()):
-                marked |= g - used
-
-            if len(used) == 0:
-                done = True
-
-        # Prepare the list of prime implicants
-        pi = marked
-        for g in list(groups.values()):
-            pi |= g
-        return pi
+
+
+    def __merge_tags(self, t1, t2, t12, tags, terms, used, use_t2 = True):
+        """Record the merge of the tagged terms t1 and t2 into t12.
+
+        The new term is an implicant of the outputs both terms are implicants
+        of; it is dropped if there are none. A term is only used up if the
+        new term keeps all of its outputs, otherwise it stays a prime
+        implicant of the outputs the new term lost. The XOR and XNOR merges
+        only use up t1, as in __merge_round.
+        """
+        tag = tags[t1] & tags[t2]
+        if not tag:
+            return
+        tags[t12] = tag
+        terms.add(t12)
+        if tag == tags[t1]:
+            used.add(t1)
+        if use_t2 and tag == tags[t2]:
+            used.add(t2)
 
 
 
-    def __get_essential_implicants(self, terms, dc):
+    def __get_essential_implicants(self, coverage):
         """Simplify the set 'terms'.
 
         Args:
-            terms (set of str): set of strings representing the minterms of
-            ones and dontcares.
-            dc (set of str): set of strings representing the dontcares.
+            coverage (dict): maps each prime implicant (as packed term) to
+            the minterms of the ON-set it covers, as bitset (see
+            __get_coverage).
 
         Returns:
-            A list of prime implicants. These are the minterms that cannot be
-            reduced with step 1 of the Quine McCluskey method.
+            A set of packed prime implicants. These are the minterms that
+            cannot be reduced with step 1 of the Quine McCluskey method.
 
         This function is usually called after __get_prime_implicants and its
         objective is to remove non-essential minterms.
@@ -413,37 +2512,164 @@ class QuineMcCluskey:
         least one other term in the list.
         """
 
-        # Create all permutations for each term in terms.
-        perms = {}
-        for t in terms:
-            perms[t] = set(p for p in self.permutations(t) if p not in dc)
-
         # Now group the remaining terms and see if any term can be covered
         # by a combination of terms.
-        ei_range = set()
+        ei_range = 0
         ei = set()
         groups = dict()
-        for t in terms:
-            n = self.__get_term_rank(t, len(perms[t]))
+        for t in coverage:
+            n = self.__get_term_rank(t, _popcount(coverage[t]))
             if n not in groups:
                 groups[n] = set()
             groups[n].add(t)
         for t in sorted(list(groups.keys()), reverse=True):
-            for g in groups[t]:
-                if not perms[g] <= ei_range:
+            for g in sorted(groups[t]):
+                if coverage[g] & ~ei_range:
                     ei.add(g)
-                    ei_range |= perms[g]
+                    ei_range |= coverage[g]
         if len(ei) == 0:
-            ei = set(['-' * self.n_bits])
+            ei = set([(0, (1 << self.n_bits) - 1, 0, 0)])
         return ei
 
 
 
+    def __get_minimum_cover(self, coverage, initial, n_ones):
+        """Select a subset of minimum cost of the prime implicants.
+
+        Args:
+            coverage (dict): maps each prime implicant (as packed term) to
+            the minterms of the ON-set it covers, as bitset.
+
+            initial (set of tuple): a valid cover, e.g. the result of
+            __get_essential_implicants.
+
+            n_ones (int): the number of minterms in the ON-set.
+
+        Returns:
+            A set of packed terms which covers the ON-set.
+
+        The number of terms is minimised first, then the complexity of the
+        terms (see __get_term_cost). The search is limited by
+        self.cover_budget and the deadline of the call; when the time runs
+        out or if the ON-set is empty the best cover found so far is
+        returned.
+        """
+        if n_ones == 0 or self.__out_of_budget():
+            # Fall back to the greedy cover.
+            return initial
+        terms = sorted(coverage)
+        columns = [coverage[t] for t in terms]
+        # Weight the number of terms higher than the complexity of any
+        # irredundant cover.
+        weight = 7 * self.n_bits * (n_ones + 1) + 1
+        costs = [weight + self.__get_term_cost(t) for t in terms]
+        index = dict((t, i) for i, t in enumerate(terms))
+
+        time_budget = self.cover_budget
+        ctx = self.__context()
+        if ctx.deadline is not None:
+            remaining = max(ctx.deadline - time.time(), 0.0)
+            time_budget = remaining if time_budget is None else min(time_budget, remaining)
+        progress = None
+        if ctx.progress is not None:
+            progress = lambda n_nodes: self.__report('cover', n_nodes)
+        solver = cover.CoverSolver(columns, costs, time_budget = time_budget, stop = ctx.cancel_event,
+                                   progress = progress)
+        selected, optimal = solver.solve((1 << n_ones) - 1, initial = [index[t] for t in initial])
+        if not optimal and not self.__out_of_budget() and self.status == 'complete':
+            self.status = 'cover_budget'
+        return set(terms[i] for i in selected)
+
+
+
+    def __get_term_cost(self, term):
+        """Calculate the complexity of a term.
+
+        Args:
+            term (tuple of int): one single term in packed format.
+
+        Returns:
+            The complexity of the term as a positive integer. Each '1'
+            counts 4, each '0' 6, each '^' 5 and each '~' 7.
+        """
+        value, mask, xor_mask, xnor_mask = term
+        n_zeros = self.n_bits - _popcount(value | mask | xor_mask | xnor_mask)
+        return 4 * _popcount(value) + 6 * n_zeros + 5 * _popcount(xor_mask) + 7 * _popcount(xnor_mask)
+
+
+
+    def __get_coverage(self, term, on_index):
+        """Calculate the minterms of the ON-set covered by a term.
+
+        Args:
+            term (tuple of int): a packed term.
+
+            on_index (dict): maps each minterm of the ON-set to its position
+            in the bitset.
+
+        Returns:
+            An integer with bit k set if the term covers the minterm at
+            position k of the ON-set.
+
+        Depending on which is smaller, this either enumerates the minterms
+        of the term or tests each minterm of the ON-set against the term.
+        """
+        value, mask, xor_mask, xnor_mask = term
+        free = mask | xor_mask | xnor_mask
+        bits = bytearray((len(on_index) + 7) // 8)
+        if (1 << _popcount(free)) <= len(on_index):
+            for n in self.__minterms(term):
+                k = on_index.get(n)
+                if k is not None:
+                    bits[k >> 3] |= 1 << (k & 7)
+        else:
+            care = ((1 << self.n_bits) - 1) & ~free
+            for n, k in on_index.items():
+                if n & care == value and \
+                        (not xor_mask or _popcount(n & xor_mask) & 1) and \
+                        (not xnor_mask or not _popcount(n & xnor_mask) & 1):
+                    bits[k >> 3] |= 1 << (k & 7)
+        return int.from_bytes(bytes(bits), 'little')
+
+
+
+    def __minterms(self, term):
+        """Iterator over all minterms covered by a packed term.
+
+        Args:
+            term (tuple of int): a packed term.
+
+        Returns:
+            The minterms as integers.
+        """
+        value, mask, xor_mask, xnor_mask = term
+        free = mask
+        fix = 0
+        parity = 0
+        xor_bits = xor_mask | xnor_mask
+        if xor_bits:
+            # The lowest XOR/XNOR bit is not enumerated but derived from the
+            # parity of the other ones: odd for XOR and even for XNOR.
+            fix = xor_bits & -xor_bits
+            free |= xor_bits ^ fix
+            parity = 1 if xor_mask & fix else 0
+        sub = 0
+        while True:
+            n = value | sub
+            if xor_bits and _popcount(n & xor_bits) & 1 != parity:
+                n |= fix
+            yield n
+            sub = (sub - free) & free
+            if sub == 0:
+                break
+
+
+
     def __get_term_rank(self, term, term_range):
         """Calculate the "rank" of a term.
 
         Args:
-            term (str): one single term in string format.
+            term (tuple of int): one single term in packed format.
 
             term_range (int): the rank of the class of term.
 
@@ -460,16 +2686,8 @@ class QuineMcCluskey:
         This means, the higher rank of a term, the more desireable it is to
         include this term in the final result.
         """
-        n = 0
-        for t in term:
-            if t == "-":
-                n += 8
-            elif t == "^":
-                n += 4
-            elif t == "~":
-                n += 2
-            elif t == "1":
-                n += 1
+        value, mask, xor_mask, xnor_mask = term
+        n = 8 * _popcount(mask) + 4 * _popcount(xor_mask) + 2 * _popcount(xnor_mask) + _popcount(value)
         return 4*term_range + n
 
 
@@ -479,7 +2697,8 @@ class QuineMcCluskey:
 
         Args:
             value (str): A string containing any of the above characters.
-            exclude (set): A set of values to skip (usually don't cares)
+            exclude (set): A set of values to skip (usually don't cares), as
+            integers or as strings of '0' and '1'.
 
         Returns:
             The output strings contain only '0' and '1'.
@@ -502,87 +2721,45 @@ class QuineMcCluskey:
             '^': all bits with the caret are XOR-ed together.
             '~': all bits with the tilde are XNOR-ed together.
 
-        Algorithm description:
-            This lovely piece of spaghetti code generates all possibe
-            permutations of a given string describing logic operations.
-            This could be achieved by recursively running through all
-            possibilities, but a more linear approach has been preferred.
-            The basic idea of this algorithm is to consider all bit
-            positions from 0 upwards (direction = +1) until the last bit
-            position. When the last bit position has been reached, then the
-            generated string is yielded.  At this point the algorithm works
-            its way backward (direction = -1) until it finds an operator
-            like '-', '^' or '~'.  The bit at this position is then flipped
-            (generally from '0' to '1') and the direction flag again
-            inverted. This way the bit position pointer (i) runs forth and
-            back several times until all possible permutations have been
-            generated.
-            When the position pointer reaches position -1, all possible
-            combinations have been visited.
-        """
-        n_bits = len(value)
-        n_xor = value.count('^') + value.count('~')
-        xor_value = 0
-        seen_xors = 0
-        res = ['0' for i in range(n_bits)]
-        i = 0
-        direction = +1
-        while i >= 0:
-            # binary constant
-            if value[i] == '0' or value[i] == '1':
-                res[i] = value[i]
-            # dontcare operator
-            elif value[i] == '-':
-                if direction == +1:
-                    res[i] = '0'
-                elif res[i] == '0':
-                    res[i] = '1'
-                    direction = +1
-            # XOR operator
-            elif value[i] == '^':
-                seen_xors = seen_xors + direction
-                if direction == +1:
-                    if seen_xors == n_xor and xor_value == 0:
-                        res[i] = '1'
-                    else:
-                        res[i] = '0'
-                else:
-                    if res[i] == '0' and seen_xors < n_xor - 1:
-                        res[i] = '1'
-                        direction = +1
-                        seen_xors = seen_xors + 1
-                if res[i] == '1':
-                    xor_value = xor_value ^ 1
-            # XNOR operator
-            elif value[i] == '~':
-                seen_xors = seen_xors + direction
-                if direction == +1:
-                    if seen_xors == n_xor and xor_value == 1:
-                        res[i] = '1'
-                    else:
-                        res[i] = '0'
-                else:
-                    if res[i] == '0' and seen_xors < n_xor - 1:
-                        res[i] = '1'
-                        direction = +1
-                        seen_xors = seen_xors + 1
-                if res[i] == '1':
-                    xor_value = xor_value ^ 1
-            # unknown input
-            else:
-                res[i] = '#'
+        See permutations_int for the algorithm.
+        """
+        fmt = '0%db' % len(value)
+        for n in self.permutations_int(value, exclude):
+            yield format(n, fmt)
+
 
-            i = i + direction
-            if i == n_bits:
-                direction = -1
-                i = n_bits - 1
-                bitstring = "".join(res)
-                if int(bitstring, base=2) not in exclude:
-                    yield bitstring
+
+    def permutations_int(self, value = '', exclude={}):
+        """Iterator to generate all possible values out of a string, as integers.
+
+        Args:
+            value (str): A string as accepted by permutations.
+            exclude (set): A set of values to skip (usually don't cares), as
+            integers or as strings of '0' and '1'.
+
+        Returns:
+            The values as integers, the last character of value being the
+            least significant bit. The order of the values is not specified.
+
+        Algorithm description:
+            The string is converted into a value and the masks of the '-',
+            '^' and '~' positions. All subsets of the free positions are
+            enumerated with the step sub = (sub - free) & free. The last
+            '^' or '~' position is not enumerated; its bit is set whenever
+            this is needed to give the XOR bits an odd (the XNOR bits an
+            even) number of ones.
+        """
+        if re.search('[^-01^~]', value):
+            raise ValueError("invalid character in term '%s'" % value)
+        if any(not isinstance(x, int) for x in exclude):
+            exclude = set(int(x, 2) if isinstance(x, str) else x for x in exclude)
+        for n in self.__minterms(self.__str2term(value)):
+            if n not in exclude:
+                yield n
 
 
 
-    def __reduce_implicants(self, implicants, dc):
+    def __reduce_implicants(self, implicants, on_index, dc):
         def get_terms(implicant):
             """Return the indexes for each type of token in given implicant string"""
             term_ones = [m.start() for m in re.finditer(re.escape('1'), implicant)]
@@ -601,56 +2778,98 @@ class QuineMcCluskey:
             ret += 1.75 * len(term_xnors)
             return ret
 
-        def combine_implicants(a, b):
-            permutations_a = set(self.permutations(a, exclude=dc))
-            permutations_b = set(self.permutations(b, exclude=dc))
-            _, _, _, _, a_term_dcs = get_terms(a)
-            _, _, _, _, b_term_dcs = get_terms(b)
-            a_potential, b_potential = list(a), list(b)
-            for index in a_term_dcs: a_potential[index] = b[index]
-            for index in b_term_dcs: b_potential[index] = a[index]
-            valid = [
-                x for x in [''.join(a_potential), ''.join(b_potential)]
-                if self.permutations(x, exclude=dc) == (permutations_a | permutations_b)
-            ]
+        dc_index = dict((n, k) for k, n in enumerate(sorted(dc)))
+        all_bits = (1 << self.n_bits) - 1
+
+        def fixed(t):
+            """The mask of the '0' and '1' positions of a packed term."""
+            return all_bits & ~(t[1] | t[2] | t[3])
+
+        def size(t):
+            """The number of minterms of a packed term."""
+            n_xor = _popcount(t[2] | t[3])
+            return 1 << (_popcount(t[1]) + max(n_xor - 1, 0))
+
+        def combine_implicants(a, b, union):
+            """Try to replace the packed terms a and b by one term.
+
+            The candidates are a with its '-' replaced by the characters of
+            b at the same positions, and vice versa. A candidate is valid if
+            it covers exactly the ON-set minterms of a and b, i.e. union, and
+            only don't cares besides.
+            """
+            valid = []
+            for x, y in ((a, b), (b, a)):
+                free = x[1]
+                candidate = (x[0] | (y[0] & free & fixed(y)), free & y[1], x[2] | (y[2] & free), x[3] | (y[3] & free))
+                if candidate[2] and candidate[3]:
+                    continue
+                if self.__get_coverage(candidate, on_index) != union:
+                    continue
+                if size(candidate) != _popcount(union) + _popcount(self.__get_coverage(candidate, dc_index)):
+                    continue
+                valid.append(self.__term2str(candidate))
             if valid: return sorted(valid, key=complexity)[0]
             return None
 
-        # Combine implicants in orthogonal spaces
-        while True:
-            for a, b in itertools.combinations(implicants, 2):
-                replacement = combine_implicants(a, b)
+        # Combine implicants in orthogonal spaces. A candidate must keep the
+        # fixed bits of both terms, so only pairs which agree on their common
+        # fixed bits are compared; they are looked up in a cube index. The
+        # terms are kept in a worklist: a term is done when no live term
+        # combines with it, and each new term is compared with all live
+        # terms.
+        terms = dict((self.__str2term(i), i) for i in implicants)
+        on_coverage = dict((t, self.__get_coverage(t, on_index)) for t in terms)
+        worklist = sorted(terms, reverse=True)
+        merge_start = time.time()
+        index = cubeindex.CubeIndex(self.n_bits, terms)
+        while worklist and not self.__out_of_budget():
+            a = worklist.pop()
+            if a not in terms:
+                continue
+            for b in sorted(index.intersecting(a)):
+                if b == a:
+                    continue
+                union = on_coverage[a] | on_coverage[b]
+                replacement = combine_implicants(a, b, union)
                 if replacement:
-                    implicants.remove(a)
-                    implicants.remove(b)
-                    implicants |= {replacement}
+                    del terms[a]
+                    del terms[b]
+                    index.discard(a)
+                    index.discard(b)
+                    x = self.__str2term(replacement)
+                    terms[x] = replacement
+                    index.add(x)
+                    on_coverage[x] = union
+                    worklist.append(x)
                     break
-            else:
-                break
 
-        # Reduce redundant implicants further by comparing their coverage
-        coverage = {
-            implicant: {n for n in self.permutations(implicant) if n not in dc}
-            for implicant in implicants
-        }
+        self.stats.times['merge'] += time.time() - merge_start
 
-        while True:
-            redundant = []
-            for this_implicant in list(coverage):
-                this_coverage = coverage[this_implicant]
-                others_coverage = {
-                    n
-                    for other_implicant in [
-                        implicant for implicant in coverage.keys()
-                        if implicant != this_implicant
-                    ]
-                    for n in coverage[other_implicant]
-                }
-                if this_coverage.issubset(others_coverage): redundant.append(this_implicant)
+        # Reduce redundant implicants further by comparing their coverage
+        coverage = dict((terms[t], on_coverage[t]) for t in terms)
+        redundancy_start = time.time()
+
+        while not self.__out_of_budget():
+            # The coverage of all other implicants is the union of the
+            # prefix and the suffix of the list of implicants.
+            keys = sorted(coverage)
+            prefix = [0]
+            for implicant in keys:
+                prefix.append(prefix[-1] | coverage[implicant])
+            suffix = [0]
+            for implicant in reversed(keys):
+                suffix.append(suffix[-1] | coverage[implicant])
+            suffix.reverse()
+            redundant = [
+                implicant for i, implicant in enumerate(keys)
+                if coverage[implicant] & ~(prefix[i] | suffix[i + 1]) == 0
+            ]
             if redundant:
                 worst = sorted(redundant, key=complexity, reverse=True)[0]
                 del coverage[worst]
             else:
                 break
+        self.stats.times['redundancy'] += time.time() - redundancy_start
         if not coverage: coverage = {'-'*self.n_bits: {}}
         return set(coverage.keys())
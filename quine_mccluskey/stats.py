@@ -0,0 +1,121 @@
+#  stats.py -- Run statistics for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""Statistics of one run of QuineMcCluskey.
+
+After each call of simplify, simplify_los, simplify_file, simplify_multi,
+start_session and the session updates, the instance holds a Stats object in
+its stats attribute and passes it to each of its hooks.
+
+The time is split into these phases:
+
+    primes      the generation of the prime implicants (for the heuristic
+                method: the heuristic minimiser)
+    coverage    building the coverage matrix of the primes over the ON-set
+    essential   the greedy selection of the initial cover
+    cover       the search for a minimum cover
+    merge       the combination of implicants in orthogonal spaces
+    redundancy  the removal of redundant implicants
+    verify      the check of the result against the ON- and DC-set, if the
+                call was made with verify = True
+
+Example:
+    def export(stats):
+        print(stats.as_dict())
+    qm = QuineMcCluskey(hooks = [export])
+
+While a call of simplify runs, its progress callable receives a Progress
+tuple at the start of the call, after each merge round of the Python merge
+loops, before each merge round and every 65536 terms of a round of the c
+backend (the numpy and zdd backends report no rounds) and from time to time
+during the cover search:
+
+    phase       'start', 'primes' or 'cover'
+    round       the number of merge rounds done so far
+    n_primes    the number of prime implicants found so far
+    n_nodes     the number of nodes of the cover search so far
+"""
+
+from __future__ import print_function
+import collections
+import contextlib
+import time
+
+
+Progress = collections.namedtuple('Progress', ('phase', 'round', 'n_primes', 'n_nodes'))
+
+
+
+class Stats:
+    """The statistics of one run."""
+    phases = ("primes", "coverage", "essential", "cover", "merge", "redundancy", "verify")
+
+
+
+    def __init__(self):
+        """The class constructor."""
+        self.start = time.time()
+        self.wall_time = 0.0            # the duration of the whole call
+        self.times = dict((p, 0.0) for p in self.phases)
+        self.primes_per_round = []      # the primes found in each merge round
+        self.terms_per_round = []       # the terms entering each merge round
+        self.peak_terms = 0             # the most implicants held at once
+        self.n_primes = 0               # the number of prime implicants
+        self.coverage_rows = 0          # the number of ON-set minterms
+        self.coverage_columns = 0       # the number of columns with coverage
+        self.coverage_entries = 0       # the number of set bits of the matrix
+        self.profile_cmp = 0
+        self.profile_xor = 0
+        self.profile_xnor = 0
+        self.n_terms = 0                # the number of terms of the result
+        self.support = None             # the inputs used, with reduce_support
+        self.symmetric_groups = []      # the groups of symmetric inputs
+        self.mismatches = None          # the wrong minterms found by verify
+        self.status = None
+
+
+
+    @contextlib.contextmanager
+    def phase(self, name):
+        """Context manager which adds the time spent in its body to a phase."""
+        t = time.time()
+        try:
+            yield
+        finally:
+            self.times[name] += time.time() - t
+
+
+
+    def as_dict(self):
+        """Return the statistics as a dict of plain values, e.g. for JSON."""
+        res = dict(self.__dict__)
+        del res['start']
+        res['times'] = dict(self.times)
+        res['primes_per_round'] = list(self.primes_per_round)
+        res['terms_per_round'] = list(self.terms_per_round)
+        if self.support is not None:
+            res['support'] = list(self.support)
+        res['symmetric_groups'] = [list(g) for g in self.symmetric_groups]
+        if self.mismatches is not None:
+            res['mismatches'] = list(self.mismatches)
+        return res
@@ -0,0 +1,223 @@
+#  truthtable.py -- A truth table file format for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""A compact file format for truth tables.
+
+A file consists of a 16 byte header followed by the table:
+
+    offset  size  contents
+    0       4     the magic bytes b'QMTT'
+    4       1     the format version (1)
+    5       1     n_bits, the number of inputs
+    6       2     flags (little endian), not interpreted by this module
+    8       8     reserved, written as zero
+
+The table holds 2 bits for each of the 2**n_bits minterms: minterm k is
+stored in bits 2 * (k % 4) and 2 * (k % 4) + 1 of byte k / 4 of the table.
+The codes are OFF (0), ON (1) and DC (2); code 3 is invalid. The table is
+padded with zero bits to a multiple of 8 bytes.
+
+The table is read through a memory map, and all-OFF stretches of the
+table are skipped 32 minterms at a time, so sparse tables with many inputs
+load quickly. A MappedTable keeps the map open: the c backend of
+QuineMcCluskey.simplify_file generates the prime implicants from the mapped
+table in place, without Python objects for the minterms. The ON- and
+DC-sets are still decoded into Python sets of ints for the cover selection
+and the final reduction (in C if the _qm extension is available).
+"""
+
+from __future__ import print_function
+import mmap
+import struct
+try:
+    from . import _qm
+except ImportError:
+    _qm = None
+
+
+MAGIC = b'QMTT'
+VERSION = 1
+HEADER = struct.Struct('<4sBBH8x')
+
+OFF, ON, DC = 0, 1, 2
+
+def _byte_terms(b):
+    """Return the offsets of the ON and DC minterms encoded in the byte b."""
+    codes = [b >> (2 * k) & 3 for k in range(4)]
+    if 3 in codes:
+        return None
+    return (tuple(k for k in range(4) if codes[k] == ON),
+            tuple(k for k in range(4) if codes[k] == DC))
+
+
+# The ON and DC offsets of each byte value, or None if the byte contains the
+# invalid code 3.
+_BYTE_TERMS = tuple(_byte_terms(b) for b in range(256))
+
+
+
+def table_size(n_bits):
+    """Return the size in bytes of the table of a n_bits function."""
+    return max(8, ((1 << n_bits) // 4 + 7) // 8 * 8)
+
+
+
+def write(path, ones, dc, n_bits, flags = 0):
+    """Write a truth table file.
+
+    Args:
+        path (str): the file name.
+        ones (iterable of int): the minterms for which the output is '1'.
+        dc (iterable of int): the don't care minterms.
+        n_bits (int): the number of inputs.
+
+    Kwargs:
+        flags (int): a 16 bit value stored in the header.
+
+    A minterm which is in ones and in dc is written as don't care.
+    """
+    table = bytearray(table_size(n_bits))
+    for code, terms in ((ON, ones), (DC, dc)):
+        for t in terms:
+            if not 0 <= t < 1 << n_bits:
+                raise ValueError("term %d does not fit in %d bits" % (t, n_bits))
+            shift = 2 * (t % 4)
+            table[t // 4] = table[t // 4] & ~(3 << shift) | code << shift
+    with open(path, 'wb') as f:
+        f.write(HEADER.pack(MAGIC, VERSION, n_bits, flags))
+        f.write(table)
+
+
+
+class MappedTable:
+    """A truth table file mapped into memory.
+
+    The object is a context manager; the map is closed on exit or by close.
+    table is a read-only memoryview of the 2 bit entries of the file.
+    """
+
+
+
+    def __init__(self, path):
+        """The class constructor.
+
+        Args:
+            path (str): the file name.
+        """
+        self.path = path
+        with open(path, 'rb') as f:
+            self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        try:
+            if len(self.mm) < HEADER.size:
+                raise ValueError("%s: file too short" % path)
+            magic, version, self.n_bits, self.flags = HEADER.unpack_from(self.mm)
+            if magic != MAGIC or version != VERSION:
+                raise ValueError("%s: not a truth table file" % path)
+            size = table_size(self.n_bits)
+            if len(self.mm) != HEADER.size + size:
+                raise ValueError("%s: the table must have %d bytes" % (path, size))
+        except ValueError:
+            self.mm.close()
+            raise
+        self.table = memoryview(self.mm)[HEADER.size:]
+
+
+
+    def close(self):
+        """Release the table and close the map."""
+        if self.table is not None:
+            self.table.release()
+            self.table = None
+            self.mm.close()
+
+
+
+    def __enter__(self):
+        return self
+
+
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+
+    def decode(self):
+        """Decode the table.
+
+        Returns:
+            A tuple (ones, dc) of the sets of the ON and DC minterms.
+        """
+        if _qm is not None:
+            try:
+                ones, dc = _qm.decode_table(self.table)
+            except ValueError as e:
+                raise ValueError("%s: %s" % (self.path, e))
+        else:
+            ones, dc = self.__decode()
+        # The padding of tables of less than 32 minterms must be OFF.
+        if self.n_bits < 5 and any(t >> self.n_bits for t in ones | dc):
+            raise ValueError("%s: term out of range" % self.path)
+        return ones, dc
+
+
+
+    def __decode(self):
+        """Decode the table without the _qm extension."""
+        table = self.table
+        words = table.cast('Q')
+        ones = set()
+        dc = set()
+        try:
+            for w, word in enumerate(words):
+                if not word:
+                    continue
+                for i in range(8 * w, 8 * w + 8):
+                    byte = table[i]
+                    if not byte:
+                        continue
+                    terms = _BYTE_TERMS[byte]
+                    if terms is None:
+                        raise ValueError("%s: invalid code at byte %d" % (self.path, i))
+                    base = 4 * i
+                    ones.update(base + k for k in terms[0])
+                    dc.update(base + k for k in terms[1])
+        finally:
+            words.release()
+        return ones, dc
+
+
+
+def read(path):
+    """Read a truth table file.
+
+    Args:
+        path (str): the file name.
+
+    Returns:
+        A tuple (n_bits, flags, ones, dc) of the number of inputs, the flags
+        of the header and the sets of the ON and DC minterms.
+    """
+    with MappedTable(path) as t:
+        ones, dc = t.decode()
+        return t.n_bits, t.flags, ones, dc
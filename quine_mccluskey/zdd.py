@@ -0,0 +1,240 @@
+#  zdd.py -- Implicit prime implicant generation for qm.py
+#
+#  Copyright (c) 2006-2016  Thomas Pircher  <tehpeh-web@tty1.net>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to
+#  deal in the Software without restriction, including without limitation the
+#  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+#  sell copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+#  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+#  IN THE SOFTWARE.
+
+
+"""Prime implicants computed implicitly with BDDs and ZDDs.
+
+The union of the ON- and the DC-set is represented as a reduced ordered
+binary decision diagram (BDD), and the set of its prime implicants as a
+zero-suppressed decision diagram (ZDD) over the literals, in the style of
+Coudert and Madre. For the top variable x of f, with the cofactors f0 and f1:
+
+    P(f) = P(f0 & f1) | ~x . (P(f0) - P(f0 & f1)) | x . (P(f1) - P(f0 & f1))
+
+No intermediate implicants are created, so the cost depends on the size of
+the diagrams instead of the number of merged terms. The primes are read from
+the ZDD on demand as packed terms (value, mask, 0, 0).
+
+BDD variable k stands for bit n_bits - 1 - k of a minterm. The ZDD has two
+variables per input: 2 * k for the literal '0' and 2 * k + 1 for '1'.
+Node 0 is the constant 0 (the empty set) and node 1 the constant 1 (the set
+containing the empty cube) in both diagrams.
+"""
+
+from __future__ import print_function
+
+
+ZERO, ONE = 0, 1
+
+
+
+class Stopped(Exception):
+    """Raised when the stop callable asks to stop."""
+
+
+
+class Manager:
+    """The node tables of a BDD and a ZDD over n_bits inputs."""
+
+
+
+    def __init__(self, n_bits):
+        """The class constructor.
+
+        Args:
+            n_bits (int): the number of inputs.
+        """
+        self.n_bits = n_bits
+        # The terminals have the largest variable index.
+        self.bdd = [(n_bits, None, None), (n_bits, None, None)]
+        self.bdd_unique = {}
+        self.zdd = [(2 * n_bits, None, None), (2 * n_bits, None, None)]
+        self.zdd_unique = {}
+        self.and_cache = {}
+        self.diff_cache = {}
+        self.prime_cache = {}
+        self.count_cache = {ZERO: 0, ONE: 1}
+
+
+
+    def __bdd_node(self, var, lo, hi):
+        """Return the BDD node (var, lo, hi), creating it if necessary."""
+        if lo == hi:
+            return lo
+        key = (var, lo, hi)
+        node = self.bdd_unique.get(key)
+        if node is None:
+            node = len(self.bdd)
+            self.bdd.append(key)
+            self.bdd_unique[key] = node
+        return node
+
+
+
+    def __zdd_node(self, var, lo, hi):
+        """Return the ZDD node (var, lo, hi), creating it if necessary."""
+        if hi == ZERO:
+            return lo
+        key = (var, lo, hi)
+        node = self.zdd_unique.get(key)
+        if node is None:
+            node = len(self.zdd)
+            self.zdd.append(key)
+            self.zdd_unique[key] = node
+        return node
+
+
+
+    def from_minterms(self, minterms):
+        """Build the BDD of a set of minterms.
+
+        Args:
+            minterms (iterable of int): the minterms where the function is 1.
+
+        Returns:
+            The BDD node of the function.
+        """
+        n_bits = self.n_bits
+
+        def build(var, terms):
+            if not terms:
+                return ZERO
+            if var == n_bits:
+                return ONE
+            bit = 1 << (n_bits - 1 - var)
+            lo = [t for t in terms if not t & bit]
+            hi = [t for t in terms if t & bit]
+            return self.__bdd_node(var, build(var + 1, lo), build(var + 1, hi))
+
+        return build(0, list(minterms))
+
+
+
+    def bdd_and(self, f, g):
+        """Return the BDD of the conjunction of f and g."""
+        if f == ZERO or g == ZERO:
+            return ZERO
+        if f == ONE:
+            return g
+        if g == ONE or f == g:
+            return f
+        if f > g:
+            f, g = g, f
+        key = (f, g)
+        res = self.and_cache.get(key)
+        if res is None:
+            var_f, lo_f, hi_f = self.bdd[f]
+            var_g, lo_g, hi_g = self.bdd[g]
+            var = min(var_f, var_g)
+            if var_f != var:
+                lo_f = hi_f = f
+            if var_g != var:
+                lo_g = hi_g = g
+            res = self.__bdd_node(var, self.bdd_and(lo_f, lo_g), self.bdd_and(hi_f, hi_g))
+            self.and_cache[key] = res
+        return res
+
+
+
+    def zdd_diff(self, p, q):
+        """Return the ZDD of the cubes of p which are not in q."""
+        if p == ZERO or p == q:
+            return ZERO
+        if q == ZERO:
+            return p
+        key = (p, q)
+        res = self.diff_cache.get(key)
+        if res is None:
+            var_p, lo_p, hi_p = self.zdd[p]
+            var_q, lo_q, hi_q = self.zdd[q]
+            if var_p < var_q:
+                res = self.__zdd_node(var_p, self.zdd_diff(lo_p, q), hi_p)
+            elif var_p > var_q:
+                res = self.zdd_diff(p, lo_q)
+            else:
+                res = self.__zdd_node(var_p, self.zdd_diff(lo_p, lo_q), self.zdd_diff(hi_p, hi_q))
+            self.diff_cache[key] = res
+        return res
+
+
+
+    def primes(self, f, stop = None):
+        """Compute the prime implicants of a function.
+
+        Args:
+            f (int): the BDD node of the function.
+
+        Kwargs:
+            stop (callable): called without arguments for each new BDD node;
+            the computation raises Stopped when it returns True.
+
+        Returns:
+            The ZDD node of the set of prime implicants.
+        """
+        if f == ZERO:
+            return ZERO
+        if f == ONE:
+            return ONE
+        res = self.prime_cache.get(f)
+        if res is None:
+            if stop is not None and stop():
+                raise Stopped()
+            var, f0, f1 = self.bdd[f]
+            both = self.primes(self.bdd_and(f0, f1), stop)
+            neg = self.zdd_diff(self.primes(f0, stop), both)
+            pos = self.zdd_diff(self.primes(f1, stop), both)
+            res = self.__zdd_node(2 * var, self.__zdd_node(2 * var + 1, both, pos), neg)
+            self.prime_cache[f] = res
+        return res
+
+
+
+    def count(self, p):
+        """Return the number of cubes of the ZDD p."""
+        res = self.count_cache.get(p)
+        if res is None:
+            _, lo, hi = self.zdd[p]
+            res = self.count(lo) + self.count(hi)
+            self.count_cache[p] = res
+        return res
+
+
+
+    def cubes(self, p):
+        """Iterator over the cubes of the ZDD p, as packed terms.
+
+        The cubes are generated one at a time from the diagram, without
+        building the whole set.
+        """
+        all_bits = (1 << self.n_bits) - 1
+        stack = [(p, 0, all_bits)]
+        while stack:
+            node, value, mask = stack.pop()
+            if node == ZERO:
+                continue
+            if node == ONE:
+                yield (value, mask, 0, 0)
+                continue
+            var, lo, hi = self.zdd[node]
+            bit = 1 << (self.n_bits - 1 - var // 2)
+            stack.append((lo, value, mask))
+            stack.append((hi, value | (bit if var & 1 else 0), mask & ~bit))
@@ -1,5 +1,5 @@
 import os
-from setuptools import setup
+from setuptools import setup, Extension
 from quine_mccluskey import qm
 
 m = qm.QuineMcCluskey
@@ -15,6 +15,12 @@ setup(
     url = "https://github.com/tpircher/quine-mccluskey",
     download_url = 'https://github.com/tpircher/quine-mccluskey/releases/tag/v%s' % m.__version__,
     packages=['quine_mccluskey', 'tests'],
+    # The compiled core is optional; qm.py falls back to the pure-Python
+    # implementation if it is not available.
+    ext_modules=[Extension('quine_mccluskey._qm', ['quine_mccluskey/_qm.c'], optional=True)],
+    # The tests exercise the numpy backend, which is skipped without NumPy.
+    extras_require={'test': ['numpy']},
+    entry_points={'console_scripts': ['qm = quine_mccluskey.cli:main']},
     long_description=open('README.md').read(),
     classifiers=[
         "Development Status :: 4 - Beta",
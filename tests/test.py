@@ -1,10 +1,23 @@
 #!/usr/bin/env python
 
 from __future__ import print_function
+import asyncio
+import io
+import json
 import os
+import random
+import shutil
 import sys
+import tempfile
+import threading
 import time
+from quine_mccluskey import qm as qm_module
 from quine_mccluskey.qm import QuineMcCluskey
+from quine_mccluskey.cache import ResultCache
+from quine_mccluskey.cubeindex import CubeIndex
+from quine_mccluskey.packedcover import PackedCover
+from quine_mccluskey import truthtable
+from quine_mccluskey import cli
 
 class TestFailure(Exception): pass
 
@@ -41,11 +54,11 @@ def format_set(s):
 
 # run function
 ###############################################################################
-def run(test_vector, use_xor):
+def run(test_vector, use_xor, backend = "python"):
     """
     Run function
     """
-    qm = QuineMcCluskey(use_xor = use_xor)
+    qm = QuineMcCluskey(use_xor = use_xor, backend = backend)
 
     for test in test_vector:
         s_out = test['res']
@@ -88,6 +101,1078 @@ def run(test_vector, use_xor):
             raise TestFailure
     print("\nTest OK.")
 
+# run_permutations function
+###############################################################################
+def run_permutations():
+    """
+    Compare permutations with a brute force evaluation of the terms.
+    """
+    qm = QuineMcCluskey()
+    for term in ['0', '-', '^^', '~~', '1--^^', '-0~~~1', '^-^1^', '~0-~~-~']:
+        n_bits = len(term)
+        expected = []
+        for n in range(1 << n_bits):
+            s = format(n, '0%db' % n_bits)
+            pairs = list(zip(term, s))
+            if any(t in '01' and t != c for t, c in pairs):
+                continue
+            ones = sum(1 for t, c in pairs if t in '^~' and c == '1')
+            if '^' in term and ones % 2 == 0 or '~' in term and ones % 2 == 1:
+                continue
+            expected.append(s)
+        exclude = expected[:1]
+        got = [sorted(qm.permutations(term)), sorted(qm.permutations(term, exclude = set(exclude))),
+               sorted(qm.permutations(term, exclude = set(int(s, 2) for s in exclude))),
+               sorted(format(n, '0%db' % n_bits) for n in qm.permutations_int(term))]
+        if got != [expected, expected[1:], expected[1:], expected]:
+            print("Error: permutations test failed")
+            print("term:        %s" % term)
+            print("expected:    [%s]" % format_set(set(expected)))
+            raise TestFailure
+    print("\nPermutations test OK.")
+
+
+# run_differential function
+###############################################################################
+def run_differential(backends, n_tests = 200):
+    """
+    Compare the backends against the pure-Python reference implementation on
+    random inputs.
+    """
+    rnd = random.Random(42)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 8)
+        use_xor = rnd.random() < 0.5
+        terms = list(range(1 << n_bits))
+        rnd.shuffle(terms)
+        n_ones = rnd.randint(1, len(terms))
+        n_dc = rnd.randint(0, len(terms) - n_ones)
+        ones = terms[:n_ones]
+        dontcares = terms[n_ones:n_ones + n_dc]
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+
+        ref = None
+        for backend in backends:
+            qm = QuineMcCluskey(use_xor = use_xor, backend = backend, cover_budget = 0.05)
+            s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+            profile = (qm.profile_cmp, qm.profile_xor, qm.profile_xnor)
+            if ref is None:
+                ref = profile
+            s_cover = generate_input(s_res)
+            if profile != ref or not s_ones <= s_cover <= s_ones | s_dontcares:
+                print("Error: differential test failed")
+                print("backend:     %s" % backend)
+                print("ones:        %s" % ones)
+                print("dontcares:   %s" % dontcares)
+                print("got:         [%s]" % format_set(s_res))
+                raise TestFailure
+
+    # Only the lower num_bits bits of the terms are used, by every backend.
+    cases = [([5], [], 2, set(['01'])), ([5], [6], 2, set(['01'])), ([1, 12], [7], 3, set(['001', '100']))]
+    for ones, dontcares, n_bits, expected in cases:
+        for backend in backends + ["zdd"]:
+            s_res = QuineMcCluskey(backend = backend).simplify(ones, dontcares, num_bits = n_bits)
+            if s_res != expected:
+                print("Error: differential test failed for terms wider than num_bits")
+                print("backend:     %s" % backend)
+                print("ones:        %s" % ones)
+                print("expected:    [%s]" % format_set(expected))
+                print("got:         [%s]" % format_set(s_res))
+                raise TestFailure
+    # The same holds for strings longer than num_bits.
+    los_cases = [(['101'], [], 2, set(['01'])), (['0101'], ['110'], 2, set(['01']))]
+    for ones, dontcares, n_bits, expected in los_cases:
+        for backend in backends + ["zdd"]:
+            s_res = QuineMcCluskey(backend = backend).simplify_los(ones, dontcares, num_bits = n_bits)
+            if s_res != expected:
+                print("Error: differential test failed for strings longer than num_bits")
+                print("backend:     %s" % backend)
+                print("ones:        %s" % ones)
+                print("expected:    [%s]" % format_set(expected))
+                print("got:         [%s]" % format_set(s_res))
+                raise TestFailure
+    print("\nDifferential test OK.")
+
+
+# run_zdd function
+###############################################################################
+def run_zdd(n_tests = 100):
+    """
+    Compare the implicit prime implicants of the zdd backend with the
+    python backend.
+    """
+    rnd = random.Random(21)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 9)
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.6) | set([0])
+        dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.3)
+        qm_ref = QuineMcCluskey(backend = "python", cover_budget = 0.05)
+        qm_ref.simplify(ones, dontcares, num_bits = n_bits)
+        qm = QuineMcCluskey(backend = "zdd", cover_budget = 0.05)
+        s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+        qm_cut = QuineMcCluskey(backend = "zdd", cover_budget = 0.05)
+        s_cut = qm_cut.simplify(ones, dontcares, num_bits = n_bits, max_primes = 3)
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+        if qm.stats.n_primes != qm_ref.stats.n_primes or qm.stats.peak_terms < qm.stats.n_primes or \
+                not s_ones <= generate_input(s_res) <= s_ones | s_dontcares or \
+                not s_ones <= generate_input(s_cut) <= s_ones | s_dontcares:
+            print("Error: zdd test failed")
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("primes:      %d, expected %d" % (qm.stats.n_primes, qm_ref.stats.n_primes))
+            print("got:         [%s], [%s]" % (format_set(s_res), format_set(s_cut)))
+            raise TestFailure
+    print("\nZDD test OK.")
+
+
+# run_cube_index function
+###############################################################################
+def run_cube_index(n_tests = 50):
+    """
+    Compare the queries of the cube index with a brute force search.
+    """
+    rnd = random.Random(22)
+
+    def random_term(n_bits):
+        free = rnd.getrandbits(n_bits)
+        xor_mask = 0
+        if rnd.random() < 0.3:
+            xor_mask = free & rnd.getrandbits(n_bits)
+            if xor_mask & (xor_mask - 1) == 0:
+                xor_mask = 0
+        value = rnd.getrandbits(n_bits) & ~free
+        mask = free & ~xor_mask
+        return (value, mask, xor_mask, 0) if rnd.random() < 0.5 else (value, mask, 0, xor_mask)
+
+    def minterms(t, n_bits):
+        res = set()
+        for m in range(1 << n_bits):
+            free = t[1] | t[2] | t[3]
+            if (m ^ t[0]) & ~free:
+                continue
+            if t[2] and not bin(m & t[2]).count('1') & 1:
+                continue
+            if t[3] and bin(m & t[3]).count('1') & 1:
+                continue
+            res.add(m)
+        return res
+
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 7)
+        all_bits = (1 << n_bits) - 1
+        terms = set(random_term(n_bits) for k in range(rnd.randint(0, 30)))
+        index = CubeIndex(n_bits, terms)
+        removed = set(t for t in terms if rnd.random() < 0.2)
+        for t in removed:
+            index.discard(t)
+        terms -= removed
+        term_minterms = dict((t, minterms(t, n_bits)) for t in terms)
+        ok = len(index) == len(terms)
+        for m in range(1 << n_bits):
+            ok = ok and set(index.covering(m)) == set(t for t in terms if m in term_minterms[t])
+        for k in range(10):
+            q = random_term(n_bits)
+            q = (q[0], q[1] | q[2] | q[3], 0, 0)
+            fixed = lambda t: all_bits & ~(t[1] | t[2] | t[3])
+            cubes = dict((t, (t[0], t[1] | t[2] | t[3], 0, 0)) for t in terms)
+            ok = ok and set(index.supercubes(q)) == \
+                    set(t for t in terms if minterms(q, n_bits) <= minterms(cubes[t], n_bits))
+            ok = ok and set(index.subcubes(q)) == \
+                    set(t for t in terms if minterms(cubes[t], n_bits) <= minterms(q, n_bits))
+            ok = ok and set(index.intersecting(q)) == \
+                    set(t for t in terms if not (t[0] ^ q[0]) & fixed(t) & fixed(q))
+        if not ok:
+            print("Error: cube index test failed")
+            print("n_bits:      %d" % n_bits)
+            print("terms:       %s" % sorted(terms))
+            raise TestFailure
+    print("\nCube index test OK.")
+
+
+# run_dc_pruning function
+###############################################################################
+def run_dc_pruning(n_tests = 50):
+    """
+    Compare the prime implicants with and without prune_dc on functions with
+    many more don't cares than ones.
+    """
+    rnd = random.Random(23)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 8)
+        use_xor = rnd.random() < 0.5
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.15) | set([0])
+        dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.8)
+        qm_ref = QuineMcCluskey(use_xor = use_xor, backend = "python", cover_budget = 0.05)
+        s_ref = qm_ref.simplify(ones, dontcares, num_bits = n_bits)
+        qm = QuineMcCluskey(use_xor = use_xor, backend = "python", cover_budget = 0.05, prune_dc = True)
+        s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+        # The reference primes which cover a one are the columns of its
+        # coverage matrix.
+        if qm.stats.n_primes != qm_ref.stats.coverage_columns or \
+                qm.stats.coverage_columns != qm.stats.n_primes or \
+                not s_ones <= generate_input(s_res) <= s_ones | s_dontcares:
+            print("Error: DC pruning test failed")
+            print("use_xor:     %s" % use_xor)
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("primes:      %d, expected %d" % (qm.stats.n_primes, qm_ref.stats.coverage_columns))
+            print("got:         [%s], expected [%s]" % (format_set(s_res), format_set(s_ref)))
+            raise TestFailure
+    print("\nDC pruning test OK.")
+
+
+# run_support function
+###############################################################################
+def run_support(n_tests = 60):
+    """
+    Compare reduce_support with the full minimisation on functions with
+    unused and symmetric inputs, and check the detected support and
+    symmetric groups by brute force.
+    """
+    rnd = random.Random(26)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 7)
+        use_xor = rnd.random() < 0.5
+        used = [b for b in range(n_bits) if rnd.random() < 0.6]
+        # A random function of the used bits, or a symmetric one.
+        symmetric = rnd.random() < 0.3
+        weights = [rnd.choice((0, 1, 2)) for w in range(n_bits + 1)]
+        table = {}
+        ones = set()
+        dontcares = set()
+        for m in range(1 << n_bits):
+            key = sum(1 for b in used if m >> b & 1) if symmetric else tuple(m >> b & 1 for b in used)
+            if key not in table:
+                table[key] = weights[key] if symmetric else rnd.choice((0, 1, 1, 2))
+            if table[key] == 1:
+                ones.add(m)
+            elif table[key] == 2:
+                dontcares.add(m)
+        if not ones:
+            ones.add(0)
+            dontcares.discard(0)
+            symmetric = False
+
+        def value(m):
+            return 1 if m in ones else 2 if m in dontcares else 0
+
+        support = [b for b in range(n_bits)
+                   if any(value(m) != value(m ^ (1 << b)) for m in range(1 << n_bits))]
+        qm_ref = QuineMcCluskey(use_xor = use_xor, cover_budget = None)
+        s_ref = qm_ref.simplify(ones, dontcares, num_bits = n_bits)
+        qm = QuineMcCluskey(use_xor = use_xor, cover_budget = None, reduce_support = True)
+        s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+        groups = qm.stats.symmetric_groups
+        ok = qm.stats.support == support and len(s_res) == len(s_ref) and qm.n_bits == n_bits
+        for g in groups:
+            for b in g[1:]:
+                pair = (1 << g[0]) | (1 << b)
+                ok = ok and all(value(m) == value(m ^ pair) for m in range(1 << n_bits)
+                                if m & pair not in (0, pair))
+        if symmetric and len([b for b in used if b in support]) > 1:
+            ok = ok and len(groups) == 1 and set(groups[0]) >= set(b for b in used if b in support)
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+        if not ok or not s_ones <= generate_input(s_res) <= s_ones | s_dontcares:
+            print("Error: support test failed")
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("support:     %s, expected %s" % (qm.stats.support, support))
+            print("groups:      %s" % groups)
+            print("got:         [%s], expected [%s]" % (format_set(s_res), format_set(s_ref)))
+            raise TestFailure
+    print("\nSupport test OK.")
+
+
+# run_decomposed function
+###############################################################################
+def run_decomposed(n_tests = 40):
+    """
+    Check that simplify_decomposed returns a valid cover, with chosen and
+    with explicit split bits, sequentially and on the worker pool.
+    """
+    rnd = random.Random(27)
+    qm_pool = QuineMcCluskey(use_xor = False, workers = 2)
+    for i in range(n_tests):
+        n_bits = rnd.randint(2, 10)
+        use_xor = rnd.random() < 0.3
+        ones = set(m for m in range(1 << n_bits) if rnd.random() < 0.4)
+        dontcares = set(m for m in range(1 << n_bits) if m not in ones and rnd.random() < 0.2)
+        if not ones:
+            ones.add(0)
+            dontcares.discard(0)
+        qm = QuineMcCluskey(use_xor = use_xor, cover_budget = 0.2)
+        qm.split_terms = 1 << rnd.randint(2, 6)
+        for split_bits in (None, rnd.sample(range(n_bits), rnd.randint(1, n_bits - 1))):
+            if i % 10 == 0:
+                s_res = qm_pool.simplify_decomposed(ones, dontcares, num_bits = n_bits, split_bits = split_bits)
+                status = qm_pool.status
+            else:
+                s_res = qm.simplify_decomposed(ones, dontcares, num_bits = n_bits, split_bits = split_bits)
+                status = qm.status
+            s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+            s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+            if not s_ones <= generate_input(s_res) <= s_ones | s_dontcares:
+                print("Error: decomposition test failed")
+                print("ones:        %s" % sorted(ones))
+                print("dontcares:   %s" % sorted(dontcares))
+                print("split bits:  %s" % split_bits)
+                print("got:         [%s] (%s)" % (format_set(s_res), status))
+                raise TestFailure
+    print("\nDecomposition test OK.")
+
+
+# run_packed_cover function
+###############################################################################
+def run_packed_cover(n_tests = 100):
+    """
+    Check the packed covers: the conversion from and to strings and bytes,
+    evaluate and verify against the expanded terms.
+    """
+    rnd = random.Random(29)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 7)
+        qm = QuineMcCluskey(use_xor = rnd.random() < 0.3, cover_budget = 0.05)
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4) | set([0])
+        dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2)
+        cover = qm.simplify_cover(ones, dontcares, num_bits = n_bits)
+        s_res = cover.to_strings()
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+        # A random cover, which is usually wrong. Like the results of
+        # simplify, a term has at most one XOR or XNOR group of two or more
+        # bits.
+        terms = set()
+        for j in range(rnd.randint(1, 4)):
+            t = [rnd.choice('01--') for k in range(n_bits)]
+            if n_bits > 1 and rnd.random() < 0.5:
+                op = rnd.choice('^~')
+                for k in rnd.sample(range(n_bits), rnd.randint(2, n_bits)):
+                    t[k] = op
+            terms.add("".join(t))
+        wrong = PackedCover.from_strings(terms)
+        expanded = set(int(t, 2) for t in generate_input(terms))
+        expected = sorted(((ones - dontcares) - expanded) | (expanded - ones - dontcares))
+        ok = s_ones <= generate_input(s_res) <= s_ones | s_dontcares and \
+                len(cover) == len(s_res) and cover.verify(ones, dontcares) == [] and \
+                PackedCover.from_bytes(cover.to_bytes()).to_strings() == s_res and \
+                PackedCover.from_bytes(wrong.to_bytes()).to_strings() == terms and \
+                wrong.evaluate(range(1 << n_bits)) == [m in expanded for m in range(1 << n_bits)] and \
+                wrong.verify(ones, dontcares) == expected and \
+                len(wrong.verify(ones, dontcares, max_mismatches = 1)) == min(1, len(expected))
+        if not ok:
+            print("Error: packed cover test failed")
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("cover:       [%s]" % format_set(s_res))
+            print("terms:       [%s]" % format_set(terms))
+            print("mismatches:  %s, expected %s" % (wrong.verify(ones, dontcares), expected))
+            raise TestFailure
+
+    # A wide function, verified minterm by minterm.
+    ones = set(rnd.getrandbits(40) for i in range(200)) - set([(1 << 40) - 1])
+    ones.add((1 << 40) - 2)
+    cover = PackedCover.from_strings(set(format(m, '040b') for m in ones) | set(['1' * 39 + '-']))
+    mismatches = cover.verify(ones)
+    if mismatches != [(1 << 40) - 1]:
+        print("Error: packed cover test failed for the wide function: %s" % mismatches)
+        raise TestFailure
+    print("\nPacked cover test OK.")
+
+
+# run_parallel function
+###############################################################################
+def run_parallel(workers = 2):
+    """
+    Compare the parallel merge rounds with the serial implementation.
+    """
+    rnd = random.Random(7)
+    n_bits = 8
+    ones = [t for t in range(1 << n_bits) if rnd.random() < 0.6]
+    ref = None
+    min_terms = qm_module.parallel.MIN_TERMS
+    for w in (1, workers):
+        qm = QuineMcCluskey(use_xor = True, backend = "python", cover_budget = 0.05, workers = w)
+        # Use the worker processes for every round.
+        qm_module.parallel.MIN_TERMS = 0
+        try:
+            s_res = qm.simplify(ones, num_bits = n_bits)
+        finally:
+            qm_module.parallel.MIN_TERMS = min_terms
+        profile = (qm.profile_cmp, qm.profile_xor, qm.profile_xnor)
+        if ref is None:
+            ref = profile
+        s_cover = generate_input(s_res)
+        if profile != ref or s_cover != set(format(t, '0%db' % n_bits) for t in ones):
+            print("Error: parallel test failed")
+            print("workers:     %d" % w)
+            raise TestFailure
+    print("\nParallel test OK.")
+
+
+# run_batch function
+###############################################################################
+def run_batch(workers = 2):
+    """
+    Compare simplify_many with individual calls to simplify.
+    """
+    rnd = random.Random(11)
+    n_bits = 6
+    functions = []
+    for i in range(20):
+        terms = list(range(1 << n_bits))
+        rnd.shuffle(terms)
+        n_ones = rnd.randint(0, 20)
+        functions.append((terms[:n_ones], terms[n_ones:n_ones + rnd.randint(0, 10)]))
+    qm = QuineMcCluskey()
+    expected = [qm.simplify(ones, dc, num_bits = n_bits) for ones, dc in functions]
+    for w in (1, workers):
+        qm = QuineMcCluskey(workers = w)
+        s_res = qm.simplify_many(functions, num_bits = n_bits)
+        if s_res != expected:
+            print("Error: batch test failed")
+            print("workers:     %d" % w)
+            raise TestFailure
+
+    # The pool uses the cache, the hooks and verify like the serial calls.
+    # The batch repeats some functions, so that they are found in the cache
+    # on the first pass.
+    functions = functions[:10] + [functions[1], ([], []), functions[4]]
+    ref = None
+    for w in (1, workers):
+        calls = []
+        cache = ResultCache()
+        qm = QuineMcCluskey(workers = w, cache = cache,
+                            hooks = [lambda st: calls.append((st.status, st.n_terms, st.mismatches,
+                                                              st.profile_cmp))])
+        s_res = [qm.simplify_many(functions, num_bits = n_bits, verify = True) for i in range(2)]
+        outcome = (s_res, calls, cache.hits, cache.misses, len(cache.entries))
+        if ref is None:
+            ref = outcome
+        if outcome != ref or s_res[0][:10] != expected[:10] or calls[0][0] != 'complete' or \
+                calls[-1][:3] != ('cached', len(expected[4]), []):
+            print("Error: batch cache test failed")
+            print("workers:     %d" % w)
+            print("calls:       %s" % calls)
+            print("cache:       %d hits, %d misses" % (cache.hits, cache.misses))
+            raise TestFailure
+    print("\nBatch test OK.")
+
+
+# run_heuristic function
+###############################################################################
+def run_heuristic(n_tests = 100):
+    """
+    Check that the heuristic method returns valid covers.
+    """
+    rnd = random.Random(9)
+    functions = []
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 8)
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4)
+        dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2)
+        functions.append((n_bits, ones | set([0]), dontcares - set([0])))
+    # A wide function made of a few large cubes.
+    n_bits = 20
+    ones = set()
+    for i in range(8):
+        mask = rnd.getrandbits(n_bits) & rnd.getrandbits(n_bits)
+        value = rnd.getrandbits(n_bits) & ~mask
+        sub = 0
+        while True:
+            ones.add(value | sub)
+            sub = (sub - mask) & mask
+            if sub == 0:
+                break
+    functions.append((n_bits, ones, set()))
+
+    for i, (n_bits, ones, dontcares) in enumerate(functions):
+        qm = QuineMcCluskey(use_xor = i % 2 == 1, method = "heuristic", cover_budget = 0.05)
+        s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+        s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+        s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+        if not s_ones <= generate_input(s_res) <= s_ones | s_dontcares:
+            print("Error: heuristic test failed")
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("got:         [%s]" % format_set(s_res))
+            raise TestFailure
+    print("\nHeuristic test OK.")
+
+
+# run_multi function
+###############################################################################
+def run_multi(n_tests = 60):
+    """
+    Check that simplify_multi returns a valid cover for each output and no
+    more distinct terms than the separate minimum covers.
+    """
+    rnd = random.Random(16)
+    for i in range(n_tests):
+        use_xor = i % 3 == 2
+        n_bits = rnd.randint(1, 5)
+        dontcares = set(t for t in range(1 << n_bits) if rnd.random() < 0.1)
+        outputs = [set(t for t in range(1 << n_bits) if rnd.random() < 0.4) for j in range(rnd.randint(1, 4))]
+        qm = QuineMcCluskey(use_xor = use_xor)
+        s_res = qm.simplify_multi(outputs, dontcares, num_bits = n_bits)
+        multi_complete = qm.status == 'complete'
+        separate = set()
+        separate_complete = True
+        for ones, res in zip(outputs, s_res):
+            s_ones = set(format(t, '0%db' % n_bits) for t in ones - dontcares)
+            s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+            if not s_ones <= generate_input(res) <= s_ones | s_dontcares:
+                print("Error: multi-output test failed")
+                print("ones:        %s" % sorted(ones))
+                print("dontcares:   %s" % sorted(dontcares))
+                print("got:         [%s]" % format_set(res))
+                raise TestFailure
+            if ones - dontcares:
+                separate |= qm.simplify(ones, dontcares, num_bits = n_bits)
+                separate_complete = separate_complete and qm.status == 'complete'
+        n_shared = len(set().union(*s_res))
+        if not use_xor and multi_complete and separate_complete and n_shared > len(separate):
+            print("Error: multi-output test failed")
+            print("outputs:     %s" % outputs)
+            print("got %d terms, the separate covers have %d" % (n_shared, len(separate)))
+            raise TestFailure
+    print("\nMulti-output test OK.")
+
+
+# run_stats function
+###############################################################################
+def run_stats():
+    """
+    Check the statistics of a call and the hooks.
+    """
+    calls = []
+    rnd = random.Random(19)
+    for backend in ["python"] + (["c"] if qm_module._qm is not None else []):
+        for use_xor in (False, True):
+            n_bits = 6
+            ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4)
+            dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2)
+            qm = QuineMcCluskey(use_xor = use_xor, backend = backend, hooks = [calls.append])
+            s_res = qm.simplify(ones, dontcares, num_bits = n_bits)
+            st = qm.stats
+            ok = len(calls) > 0 and calls[-1] is st and st.status == qm.status and \
+                    st.n_terms == len(s_res) and st.coverage_rows == len(ones) and \
+                    st.n_primes >= st.coverage_columns > 0 and st.peak_terms >= st.n_primes and \
+                    set(st.times) == set(st.phases) and st.wall_time >= sum(st.times.values()) and \
+                    (st.profile_cmp, st.profile_xor, st.profile_xnor) == (qm.profile_cmp, qm.profile_xor, qm.profile_xnor)
+            if backend == "python":
+                ok = ok and sum(st.primes_per_round) == st.n_primes and len(st.terms_per_round) > 1
+            if not ok:
+                print("Error: stats test failed")
+                print("backend:     %s, use_xor: %s" % (backend, use_xor))
+                print("stats:       %s" % st.as_dict())
+                raise TestFailure
+    n_calls = len(calls)
+    qm.start_session([1, 3, 5], [7])
+    qm.add_ones([6])
+    if len(calls) != n_calls + 2 or qm.stats.n_terms != len(qm.add_dc([])):
+        print("Error: stats test failed for a session")
+        raise TestFailure
+    print("\nStats test OK.")
+
+
+# run_threads function
+###############################################################################
+def run_threads(n_threads = 8, n_calls = 10):
+    """
+    Check that one instance can serve several threads at the same time.
+    """
+    rnd = random.Random(20)
+    functions = []
+    for i in range(n_threads * n_calls):
+        n_bits = rnd.randint(2, 7)
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4) | set([1])
+        functions.append((n_bits, ones))
+    expected = [QuineMcCluskey(backend = "python").simplify(ones, num_bits = n_bits) for n_bits, ones in functions]
+    shared = QuineMcCluskey(backend = "python")
+    errors = []
+
+    def worker(k):
+        for i in range(k, len(functions), n_threads):
+            n_bits, ones = functions[i]
+            res = shared.simplify(ones, num_bits = n_bits)
+            if res != expected[i] or shared.n_bits != n_bits or shared.stats.n_terms != len(res):
+                errors.append(i)
+
+    threads = [threading.Thread(target = worker, args = (k,)) for k in range(n_threads)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    if errors:
+        print("Error: thread test failed for the functions %s" % sorted(errors))
+        raise TestFailure
+    print("\nThread test OK.")
+
+
+# run_async function
+###############################################################################
+def run_async(n_tests = 20):
+    """
+    Check simplify_async and simplify_task: the results, the progress
+    events, cancel() and the cancellation of the awaiting task.
+    """
+    rnd = random.Random(28)
+    errors = []
+
+    async def check_results():
+        qm = QuineMcCluskey(backend = "python")
+        for i in range(n_tests):
+            n_bits = rnd.randint(2, 8)
+            ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4) | set([1])
+            expected = QuineMcCluskey(backend = "python").simplify(ones, num_bits = n_bits)
+            task = qm.simplify_task(ones, num_bits = n_bits)
+            events = [p async for p in task]
+            res = await task
+            rounds = [p.round for p in events if p.phase == 'primes']
+            if res != expected or events[0].phase != 'start' or \
+                    rounds != list(range(1, len(task.stats.primes_per_round) + 1)):
+                errors.append("results of %s: %s %s" % (sorted(ones), res, events))
+            res = await qm.simplify_async(ones, num_bits = n_bits)
+            if res != expected or qm.n_bits != n_bits or qm.status != 'complete':
+                errors.append("simplify_async of %s: %s" % (sorted(ones), res))
+
+    async def check_cancel():
+        qm = QuineMcCluskey(backend = "python")
+        ones = set(t for t in range(1 << 12) if rnd.random() < 0.5)
+        task = qm.simplify_task(ones, num_bits = 12)
+        async for p in task:
+            if p.phase == 'primes':
+                task.cancel()
+        res = await task
+        s_ones = set(format(t, '012b') for t in ones)
+        if task.status != 'cancelled' or generate_input(res) != s_ones:
+            errors.append("cancel: %s" % task.status)
+
+        # Cancelling the awaiting task cancels the call; the event loop keeps
+        # running meanwhile.
+        ticks = []
+
+        async def ticker():
+            while True:
+                ticks.append(1)
+                await asyncio.sleep(0.001)
+
+        tick_task = asyncio.ensure_future(ticker())
+        call = asyncio.ensure_future(qm.simplify_async(ones, num_bits = 12))
+        await asyncio.sleep(0.05)
+        call.cancel()
+        try:
+            await call
+            errors.append("cancelled call returned")
+        except asyncio.CancelledError:
+            pass
+        tick_task.cancel()
+        if not ticks:
+            errors.append("the event loop was blocked")
+
+        # The c backend sees the cancellation at the checkpoints of its merge
+        # rounds: here at the first one, before any comparison.
+        if qm_module._qm is not None:
+            qm = QuineMcCluskey(backend = "c", use_xor = True, cover_budget = 0.05)
+            task = qm.simplify_task(ones, num_bits = 12)
+            task.cancel()
+            res = await task
+            if task.status != 'cancelled' or task.stats.profile_cmp != 0 or \
+                    generate_input(res) != s_ones:
+                errors.append("cancel of the c backend: %s, %d comparisons" % (
+                    task.status, task.stats.profile_cmp))
+
+    asyncio.run(check_results())
+    asyncio.run(check_cancel())
+
+    # A progress callable which cancels the call after the first merge round
+    # of the c backend stops it within the native merge rounds.
+    if qm_module._qm is not None:
+        qm = QuineMcCluskey(backend = "c", use_xor = True, cover_budget = 0.05)
+        ones = set(t for t in range(1 << 12) if rnd.random() < 0.5)
+        qm.simplify(ones, num_bits = 12)
+        n_cmp = qm.profile_cmp
+        res = qm.simplify(ones, num_bits = 12, progress = lambda p: p.phase == 'primes' and p.round >= 1)
+        if qm.status != 'cancelled' or not 0 < qm.profile_cmp < n_cmp or \
+                generate_input(res) != set(format(t, '012b') for t in ones):
+            errors.append("progress cancel of the c backend: %s, %d of %d comparisons" % (
+                qm.status, qm.profile_cmp, n_cmp))
+    if errors:
+        print("Error: async test failed")
+        for e in errors:
+            print(e)
+        raise TestFailure
+    print("\nAsync test OK.")
+
+
+# run_budget function
+###############################################################################
+def run_budget():
+    """
+    Check that calls which are cut short still return a valid cover.
+    """
+    rnd = random.Random(6)
+    n_bits = 12
+    ones = [t for t in range(1 << n_bits) if rnd.random() < 0.3]
+    s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+    qm = QuineMcCluskey(use_xor = True, backend = "python")
+    for kwargs, status in ((dict(deadline = 0), 'deadline'),
+                           (dict(deadline = 0.2), 'deadline'),
+                           (dict(max_primes = 100), 'max_primes'),
+                           (dict(), 'cancelled')):
+        timer = None
+        if status == 'cancelled':
+            timer = threading.Timer(0.05, qm.cancel)
+            timer.start()
+        s_res = qm.simplify(ones, num_bits = n_bits, **kwargs)
+        if timer is not None:
+            timer.join()
+        if qm.status != status or generate_input(s_res) != s_ones:
+            print("Error: budget test failed")
+            print("kwargs:      %s" % kwargs)
+            print("status:      %s" % qm.status)
+            raise TestFailure
+    print("\nBudget test OK.")
+
+
+# run_session function
+###############################################################################
+def run_session(n_tests = 30):
+    """
+    Compare incremental updates of a session with simplify from scratch.
+    """
+    rnd = random.Random(8)
+    for i in range(n_tests):
+        use_xor = i % 3 == 0
+        n_bits = rnd.randint(3, 5 if use_xor else 7)
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.4)
+        dontcares = set(t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.15)
+        qm_session = QuineMcCluskey(use_xor = use_xor, cover_budget = 1.0)
+        qm = QuineMcCluskey(use_xor = use_xor, cover_budget = 1.0)
+        qm_session.start_session(ones, dontcares, num_bits = n_bits)
+        for step in range(6):
+            op = rnd.choice(['add_ones', 'remove_ones', 'add_dc', 'remove_dc'])
+            terms = set(rnd.sample(range(1 << n_bits), rnd.randint(1, 3)))
+            s_res = getattr(qm_session, op)(terms)
+            if op == 'add_ones':
+                ones |= terms
+                dontcares -= terms
+            elif op == 'remove_ones':
+                ones -= terms
+            elif op == 'add_dc':
+                dontcares |= terms
+                ones -= terms
+            else:
+                dontcares -= terms
+            expected = qm.simplify(ones, dontcares, num_bits = n_bits)
+            if expected is None or not ones:
+                ok = s_res == expected
+            else:
+                s_ones = set(format(t, '0%db' % n_bits) for t in ones)
+                s_dontcares = set(format(t, '0%db' % n_bits) for t in dontcares)
+                ok = len(s_res) == len(expected) and s_ones <= generate_input(s_res) <= s_ones | s_dontcares
+            if not ok:
+                print("Error: session test failed")
+                print("use_xor:     %s" % use_xor)
+                print("%-12s %s" % (op + ":", sorted(terms)))
+                print("ones:        %s" % sorted(ones))
+                print("dontcares:   %s" % sorted(dontcares))
+                print("expected:    [%s]" % format_set(expected))
+                print("got:         [%s]" % format_set(s_res))
+                raise TestFailure
+    print("\nSession test OK.")
+
+
+# run_truth_table function
+###############################################################################
+def run_truth_table():
+    """
+    Compare truth table and iterator inputs with lists of terms.
+    """
+    rnd = random.Random(3)
+    for n_bits in (2, 3, 6):
+        ones = [t for t in range(1 << n_bits) if rnd.random() < 0.4]
+        dontcares = [t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2]
+        table_ones = bytearray(max(1, (1 << n_bits) // 8))
+        table_dontcares = bytearray(len(table_ones))
+        for t in ones:
+            table_ones[t // 8] |= 1 << (t % 8)
+        for t in dontcares:
+            table_dontcares[t // 8] |= 1 << (t % 8)
+        qm = QuineMcCluskey(use_xor = True)
+        expected = qm.simplify(ones, dontcares, num_bits = n_bits)
+        results = [qm.simplify(iter(ones), iter(dontcares), num_bits = n_bits),
+                   qm.simplify(bytes(table_ones), table_dontcares, num_bits = n_bits)]
+        if n_bits >= 3:
+            results.append(qm.simplify(table_ones, table_dontcares))
+        for s_res in results:
+            if s_res != expected:
+                print("Error: truth table test failed")
+                print("ones:        %s" % ones)
+                print("expected:    [%s]" % format_set(expected))
+                print("got:         [%s]" % format_set(s_res))
+                raise TestFailure
+    print("\nTruth table test OK.")
+
+
+# run_truth_table_file function
+###############################################################################
+def run_truth_table_file():
+    """
+    Compare simplify_file with simplify on the same function.
+    """
+    rnd = random.Random(4)
+    tmpdir = tempfile.mkdtemp()
+    try:
+        path = os.path.join(tmpdir, 'table.qmtt')
+        for n_bits in (1, 3, 5, 7):
+            ones = [t for t in range(1 << n_bits) if rnd.random() < 0.4]
+            dontcares = [t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2]
+            truthtable.write(path, ones, dontcares, n_bits, flags = 0x1234)
+            r_bits, r_flags, r_ones, r_dontcares = truthtable.read(path)
+            if (r_bits, r_flags, r_ones, r_dontcares) != (n_bits, 0x1234, set(ones), set(dontcares)):
+                print("Error: truth table file round trip failed")
+                raise TestFailure
+            for backend in ["python"] + (["c"] if qm_module._qm is not None else []):
+                qm = QuineMcCluskey(use_xor = True, backend = backend)
+                expected = qm.simplify(ones, dontcares, num_bits = n_bits)
+                expected_profile = (qm.profile_cmp, qm.profile_xor, qm.profile_xnor)
+                s_res = qm.simplify_file(path)
+                if s_res != expected or (qm.profile_cmp, qm.profile_xor, qm.profile_xnor) != expected_profile:
+                    print("Error: truth table file test failed (backend %s)" % backend)
+                    print("ones:        %s" % ones)
+                    print("expected:    [%s]" % format_set(expected))
+                    print("got:         [%s]" % format_set(s_res))
+                    raise TestFailure
+
+        # An entry with the invalid code 3 is rejected by every reader.
+        truthtable.write(path, [1], [], 8)
+        with open(path, 'r+b') as f:
+            f.seek(truthtable.HEADER.size + 10)
+            f.write(b'\x30')
+        for backend in ["python"] + (["c"] if qm_module._qm is not None else []):
+            try:
+                QuineMcCluskey(backend = backend).simplify_file(path)
+            except ValueError as e:
+                if "byte 10" not in str(e):
+                    print("Error: wrong message for an invalid truth table entry: %s" % e)
+                    raise TestFailure
+            else:
+                print("Error: invalid truth table entry accepted (backend %s)" % backend)
+                raise TestFailure
+    finally:
+        shutil.rmtree(tmpdir)
+    print("\nTruth table file test OK.")
+
+
+# run_cli function
+###############################################################################
+def run_cli():
+    """
+    Run the command line tool on files in each input format and compare the
+    results with simplify.
+    """
+    tmpdir = tempfile.mkdtemp()
+    try:
+        files = {
+            'a.pla': ".i 3\n.o 2\n.ob f g\n1-0 1-\n011 01\n111 11\n.e\n",
+            'b.blif': ".model m\n.inputs a b c\n.outputs f g\n.names a b f\n11 1\n.names a c g\n0- 0\n.end\n",
+            'c.json': '[{"name": "x", "ones": [1, 2, 5, 6]}, {"ones": [3], "dc": [7], "n_bits": 3}]',
+        }
+        for name, text in files.items():
+            with open(os.path.join(tmpdir, name), 'w') as f:
+                f.write(text)
+        truthtable.write(os.path.join(tmpdir, 'd.qmtt'), [1, 2], [3], 2)
+        expected = {
+            'a.pla:f': ([4, 6, 7], []), 'a.pla:g': ([3, 7], [4, 6]),
+            'b.blif:f': ([3], []), 'b.blif:g': ([2, 3], []),
+            'x': ([1, 2, 5, 6], []), 'c.json:1': ([3], [7]), 'd.qmtt': ([1, 2], [3]),
+        }
+        paths = [os.path.join(tmpdir, name) for name in sorted(files) + ['d.qmtt']]
+        for jobs in (1, 2):
+            stdout = sys.stdout
+            sys.stdout = io.StringIO()
+            try:
+                verify = ['--verify'] if jobs == 2 else []
+                status = cli.main(['--json', '--xor', '--jobs', str(jobs)] + verify + paths)
+                output = sys.stdout.getvalue()
+            finally:
+                sys.stdout = stdout
+            results = [json.loads(line) for line in output.splitlines()]
+            got = dict((r['name'].replace(tmpdir + os.sep, ''), set(r['terms'])) for r in results)
+            qm = QuineMcCluskey(use_xor = True)
+            ref = dict((name, qm.simplify(ones, dc, num_bits = 2 if name == 'd.qmtt' else None))
+                       for name, (ones, dc) in expected.items())
+            verified = all(r.get('mismatches') == [] for r in results) if verify else True
+            if status != 0 or got != ref or not verified:
+                print("Error: command line test failed")
+                print("expected:    %s" % ref)
+                print("got:         %s" % got)
+                raise TestFailure
+
+        # A truth table with an invalid code is reported, and the results of
+        # the other inputs are still written.
+        bad = os.path.join(tmpdir, 'e.qmtt')
+        truthtable.write(bad, [1, 2], [3], 2)
+        with open(bad, 'r+b') as f:
+            f.seek(truthtable.HEADER.size + 1)
+            f.write(b'\x03')
+        for jobs in (1, 2):
+            stdout, stderr = sys.stdout, sys.stderr
+            sys.stdout, sys.stderr = io.StringIO(), io.StringIO()
+            try:
+                status = cli.main(['--json', '--jobs', str(jobs), bad] + paths)
+                output, errors = sys.stdout.getvalue(), sys.stderr.getvalue()
+            finally:
+                sys.stdout, sys.stderr = stdout, stderr
+            if status != 1 or len(output.splitlines()) != len(expected) or \
+                    errors != "qm: %s: invalid code at byte 1\n" % bad:
+                print("Error: command line test failed for an invalid truth table")
+                print("status:      %d" % status)
+                print("errors:      %s" % errors)
+                raise TestFailure
+    finally:
+        shutil.rmtree(tmpdir)
+    print("\nCommand line test OK.")
+
+
+# run_verify function
+###############################################################################
+def run_verify(n_tests = 60):
+    """
+    Check the results of simplify with verify=True, and that a wrong result
+    from a tampered cache is reported.
+    """
+    rnd = random.Random(30)
+    for i in range(n_tests):
+        n_bits = rnd.randint(1, 10)
+        use_xor = n_bits <= 6 and rnd.random() < 0.5
+        ones = set(t for t in range(1 << n_bits) if rnd.random() < 0.3) | set([1 % (1 << n_bits)])
+        dontcares = set(t for t in range(1 << n_bits) if rnd.random() < 0.1)
+        qm = QuineMcCluskey(use_xor = use_xor, cover_budget = 0.05)
+        res = qm.simplify(ones, dontcares, num_bits = n_bits, verify = True)
+        if qm.stats.mismatches != [] or qm.stats.as_dict()['mismatches'] != []:
+            print("Error: verify test failed")
+            print("ones:        %s" % sorted(ones))
+            print("dontcares:   %s" % sorted(dontcares))
+            print("got:         [%s], mismatches %s" % (format_set(res), qm.stats.mismatches))
+            raise TestFailure
+        qm.simplify(ones, dontcares, num_bits = n_bits)
+        if qm.stats.mismatches is not None:
+            print("Error: verify test failed: mismatches without verify")
+            raise TestFailure
+
+    # A sparse function of 20 inputs is checked on the care minterms only;
+    # this must take less time than the simplification itself.
+    n_bits = 20
+    ones = set(rnd.getrandbits(n_bits) for i in range(300))
+    for i in range(4):
+        base = rnd.getrandbits(n_bits) & ~0xff
+        ones.update(base | t for t in range(0x100))
+    dontcares = set(rnd.getrandbits(n_bits) for i in range(100)) - ones
+    qm = QuineMcCluskey(cover_budget = 0.05)
+    res = qm.simplify(ones, dontcares, num_bits = n_bits, verify = True)
+    t_simplify = qm.stats.wall_time - qm.stats.times['verify']
+    if qm.stats.mismatches != [] or qm.stats.times['verify'] > t_simplify:
+        print("Error: verify test failed for a sparse function: %s, %.4f s verify, %.4f s simplify" % (
+            qm.stats.mismatches, qm.stats.times['verify'], t_simplify))
+        raise TestFailure
+    cover = PackedCover.from_strings(res, n_bits)
+    wrong = PackedCover.from_strings(set(list(res)[1:]) | set(['0' * n_bits]), n_bits)
+    missing = set(ones) - set(m for m in ones if wrong.covers(m))
+    mismatches = wrong.verify(ones, dontcares)
+    if cover.verify(ones, dontcares) != [] or not missing <= set(mismatches) or \
+            (0 not in ones | dontcares and 0 not in mismatches):
+        print("Error: verify test failed for a wrong sparse cover: %s" % mismatches)
+        raise TestFailure
+
+    cache = ResultCache(canonical = False)
+    qm = QuineMcCluskey(cache = cache)
+    qm.simplify([1, 3, 5, 7], num_bits = 3)
+    for key in cache.entries:
+        cache.entries[key] = frozenset(['-01'])
+    res = qm.simplify([1, 3, 5, 7], num_bits = 3, verify = True)
+    if qm.status != 'cached' or qm.stats.mismatches != [3, 7]:
+        print("Error: verify test failed for a wrong cached result: [%s], %s" % (
+            format_set(res), qm.stats.mismatches))
+        raise TestFailure
+    print("\nVerify test OK.")
+
+
+# run_cache function
+###############################################################################
+def run_cache():
+    """
+    Check that cached results for permuted and complemented inputs are valid.
+    """
+    rnd = random.Random(5)
+    tmpdir = tempfile.mkdtemp()
+    try:
+        for use_xor in (False, True):
+            cache = ResultCache(path = os.path.join(tmpdir, 'cache%d' % use_xor))
+            qm = QuineMcCluskey(use_xor = use_xor, cache = cache)
+            n_bits = 5
+            ones = [t for t in range(1 << n_bits) if rnd.random() < 0.5]
+            dontcares = [t for t in range(1 << n_bits) if t not in ones and rnd.random() < 0.2]
+            ref = qm.simplify(ones, dontcares, num_bits = n_bits)
+            for i in range(10):
+                perm = list(range(n_bits))
+                rnd.shuffle(perm)
+                flip = rnd.randint(0, (1 << n_bits) - 1)
+                remap = lambda t: sum(((t ^ flip) >> k & 1) << perm[k] for k in range(n_bits))
+                p_ones = [remap(t) for t in ones]
+                p_dontcares = [remap(t) for t in dontcares]
+                s_res = qm.simplify(p_ones, p_dontcares, num_bits = n_bits)
+                s_ones = set(format(t, '0%db' % n_bits) for t in p_ones)
+                s_dontcares = set(format(t, '0%db' % n_bits) for t in p_dontcares)
+                s_cover = generate_input(s_res)
+                if len(s_res) != len(ref) or not s_ones <= s_cover <= s_ones | s_dontcares:
+                    print("Error: cache test failed")
+                    print("ones:        %s" % p_ones)
+                    print("dontcares:   %s" % p_dontcares)
+                    print("got:         [%s]" % format_set(s_res))
+                    raise TestFailure
+            cache.close()
+
+            # The persistent store must return the first result again.
+            cache = ResultCache(path = os.path.join(tmpdir, 'cache%d' % use_xor))
+            qm = QuineMcCluskey(use_xor = use_xor, cache = cache)
+            if qm.simplify(ones, dontcares, num_bits = n_bits) != ref or cache.hits != 1:
+                print("Error: persistent cache test failed")
+                raise TestFailure
+            cache.close()
+
+        # Results cut short by the cover_budget are not stored, and the
+        # options which change the result are part of the key.
+        cache = ResultCache()
+        ones, dontcares = set(range(0, 1 << 10, 3)), set(range(0, 1 << 10, 7))
+        QuineMcCluskey(cache = cache, cover_budget = 0.0).simplify(ones, dontcares, num_bits = 10)
+        QuineMcCluskey(cache = cache, backend = "python").simplify(ones, dontcares, num_bits = 10)
+        qm = QuineMcCluskey(cache = cache, cover_budget = None)
+        qm.simplify(ones, dontcares, num_bits = 10)
+        if qm.status == 'cached' or len(cache.entries) != 2:
+            print("Error: cache test failed: %s, %d entries" % (qm.status, len(cache.entries)))
+            raise TestFailure
+        for kwargs in (dict(cover_budget = None), dict(backend = "python"),
+                       dict(cover_budget = None, prune_dc = True), dict(cover_budget = None, reduce_support = True)):
+            qm = QuineMcCluskey(cache = cache, **kwargs)
+            qm.simplify(ones, dontcares, num_bits = 10)
+            if qm.status != 'cached' and kwargs in (dict(cover_budget = None), dict(backend = "python")):
+                print("Error: cache test failed: no hit for %s" % kwargs)
+                raise TestFailure
+            if qm.status == 'cached' and len(kwargs) == 2:
+                print("Error: cache test failed: shared entry for %s" % kwargs)
+                raise TestFailure
+    finally:
+        shutil.rmtree(tmpdir)
+    print("\nCache test OK.")
+
+
 # main function
 ###############################################################################
 def main():
@@ -118,9 +1203,41 @@ def main():
         { 'res': set(['^^^00', '111^^']) },
         { 'res': set(['---00000^^^^^^^']) },
     ]
+    backends = ["python"]
+    if qm_module.numpy_backend is not None:
+        backends.append("numpy")
+    else:
+        print("NumPy is not available: skipping the numpy backend")
+    if qm_module._qm is not None:
+        backends.append("c")
+    else:
+        print("The compiled module is not available: skipping the c backend")
     try:
-        res = run(common_test_vector + noxor_test_vector, use_xor=False)
-        res = run(common_test_vector + xor_test_vector, use_xor=True)
+        for backend in backends:
+            res = run(common_test_vector + noxor_test_vector, use_xor=False, backend=backend)
+            res = run(common_test_vector + xor_test_vector, use_xor=True, backend=backend)
+        run_permutations()
+        run_differential(backends)
+        run_zdd()
+        run_cube_index()
+        run_dc_pruning()
+        run_support()
+        run_decomposed()
+        run_packed_cover()
+        run_parallel()
+        run_batch()
+        run_heuristic()
+        run_multi()
+        run_stats()
+        run_threads()
+        run_async()
+        run_budget()
+        run_session()
+        run_truth_table()
+        run_truth_table_file()
+        run_cli()
+        run_cache()
+        run_verify()
     except TestFailure: return 1
     return 0
 